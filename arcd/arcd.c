@@ -32,6 +32,49 @@ static const arcd_range_t RANGE_THREE_FOURTH = 3 * RANGE_ONE_FOURTH;
  */
 static const unsigned CONTINUATION_BIT = 0;
 
+/* LOG2_TABLE[i] = log2(1 + i / 2^LOG2_TABLE_BITS) with ARCD_COST_FRAC_BITS
+ * fractional bits. Used by size estimation.
+ */
+enum { LOG2_TABLE_BITS = 8 };
+static const unsigned LOG2_TABLE[(1 << LOG2_TABLE_BITS) + 1] =
+{
+	0, 369, 736, 1102, 1466, 1829, 2190, 2551,
+	2909, 3267, 3623, 3978, 4331, 4683, 5034, 5384,
+	5732, 6079, 6425, 6769, 7112, 7454, 7795, 8134,
+	8473, 8810, 9146, 9480, 9814, 10146, 10477, 10807,
+	11136, 11464, 11791, 12116, 12440, 12764, 13086, 13407,
+	13727, 14046, 14363, 14680, 14996, 15310, 15624, 15937,
+	16248, 16559, 16868, 17177, 17484, 17791, 18096, 18401,
+	18704, 19007, 19308, 19609, 19909, 20207, 20505, 20802,
+	21098, 21393, 21687, 21980, 22272, 22564, 22854, 23144,
+	23433, 23720, 24007, 24293, 24579, 24863, 25146, 25429,
+	25711, 25992, 26272, 26551, 26830, 27108, 27384, 27660,
+	27936, 28210, 28484, 28757, 29029, 29300, 29571, 29840,
+	30109, 30378, 30645, 30912, 31178, 31443, 31707, 31971,
+	32234, 32496, 32758, 33019, 33279, 33538, 33797, 34055,
+	34312, 34569, 34825, 35080, 35334, 35588, 35841, 36094,
+	36346, 36597, 36847, 37097, 37346, 37595, 37842, 38090,
+	38336, 38582, 38827, 39072, 39316, 39559, 39802, 40044,
+	40286, 40527, 40767, 41006, 41246, 41484, 41722, 41959,
+	42196, 42432, 42667, 42902, 43137, 43370, 43603, 43836,
+	44068, 44300, 44530, 44761, 44990, 45220, 45448, 45676,
+	45904, 46131, 46357, 46583, 46809, 47034, 47258, 47482,
+	47705, 47928, 48150, 48372, 48593, 48813, 49034, 49253,
+	49472, 49691, 49909, 50127, 50344, 50560, 50776, 50992,
+	51207, 51422, 51636, 51850, 52063, 52276, 52488, 52700,
+	52911, 53122, 53332, 53542, 53751, 53960, 54169, 54377,
+	54584, 54791, 54998, 55204, 55410, 55615, 55820, 56025,
+	56229, 56432, 56635, 56838, 57040, 57242, 57443, 57644,
+	57845, 58045, 58245, 58444, 58643, 58841, 59039, 59237,
+	59434, 59631, 59827, 60023, 60219, 60414, 60609, 60803,
+	60997, 61190, 61384, 61576, 61769, 61961, 62152, 62343,
+	62534, 62725, 62915, 63104, 63294, 63483, 63671, 63859,
+	64047, 64234, 64421, 64608, 64794, 64980, 65166, 65351,
+	65536,
+
+};
+STATIC_ASSERT(log2_table_fits_in_cost, ARCD_COST_FRAC_BITS == 16);
+
 static void state_init(_arcd_state *const state,
 					   void *const model, void *const io)
 {
@@ -44,9 +87,39 @@ static void state_init(_arcd_state *const state,
 	state->io = io;
 }
 
+/* Returns log2(x) with ARCD_COST_FRAC_BITS fractional bits. Mantissa is
+ * rounded to LOG2_TABLE_BITS bits.
+ */
+static arcd_cost_t log2_fixed(unsigned x)
+{
+	assert(0 < x);
+	/* Normalize x to [2^LOG2_TABLE_BITS, 2^(LOG2_TABLE_BITS + 1)], so that
+	 * log2(x) = exponent + log2(x_normalized / 2^LOG2_TABLE_BITS). Rounding
+	 * can produce the upper bound, that's why table has one extra item.
+	 */
+	unsigned exponent = LOG2_TABLE_BITS;
+	unsigned shift = 0;
+	while (x >> shift >= 2u << LOG2_TABLE_BITS)
+	{
+		++shift;
+	}
+	if (0 < shift)
+	{
+		x = (x + (1u << (shift - 1))) >> shift;
+		exponent += shift;
+	}
+	for (; x < 1u << LOG2_TABLE_BITS; x <<= 1)
+	{
+		--exponent;
+	}
+	return ((arcd_cost_t)exponent << ARCD_COST_FRAC_BITS) +
+		   LOG2_TABLE[x - (1u << LOG2_TABLE_BITS)];
+}
+
 static void output_bit(arcd_enc *const e, const unsigned bit)
 {
 	assert(0 == bit || 1 == bit);
+	++e->_cost;
 	e->_state.buf |= bit << (ARCD_BUF_BITS - ++e->_state.buf_bits);
 	if (ARCD_BUF_BITS == e->_state.buf_bits)
 	{
@@ -59,6 +132,13 @@ static void output_bit(arcd_enc *const e, const unsigned bit)
 static void output_bits(arcd_enc *const e, const unsigned bit)
 {
 	assert(0 == bit || 1 == bit);
+	if (0 == e->_output)
+	{
+		/* Dry run, only count bits. */
+		e->_cost += 1 + e->_pending;
+		e->_pending = 0;
+		return;
+	}
 	output_bit(e, bit);
 	for (const unsigned inv = !bit; 0 < e->_pending; --e->_pending)
 	{
@@ -111,12 +191,28 @@ void arcd_enc_init(arcd_enc *const e,
 	e->_getprob = getprob;
 	e->_output = output;
 	e->_pending = 0;
+	e->_estimate = 0;
+	e->_cost = 0;
+}
+
+void arcd_enc_init_estimate(arcd_enc *const e,
+							const arcd_getprob_t getprob, void *const model)
+{
+	arcd_enc_init(e, getprob, model, 0, 0);
+	e->_estimate = 1;
 }
 
 void arcd_enc_put(arcd_enc *const e, const arcd_char_t ch)
 {
 	arcd_prob prob;
 	e->_getprob(ch, &prob, e->_state.model);
+	if (e->_estimate)
+	{
+		assert(prob.lower < prob.upper);
+		assert(prob.upper <= prob.total);
+		e->_cost += log2_fixed(prob.total) - log2_fixed(prob.upper - prob.lower);
+		return;
+	}
 	zoom_in(&e->_state, &prob);
 	for (;;)
 	{
@@ -149,6 +245,10 @@ void arcd_enc_put(arcd_enc *const e, const arcd_char_t ch)
 
 void arcd_enc_fin(arcd_enc *const e)
 {
+	if (e->_estimate)
+	{
+		return;
+	}
 	if (RANGE_MIN == e->_state.lower && 0 == e->_pending)
 	{
 		assert(RANGE_ONE_HALF < e->_state.upper);
@@ -167,7 +267,12 @@ void arcd_enc_fin(arcd_enc *const e)
 	}
 	else
 	{
-		if (RANGE_MIN != e->_state.lower && RANGE_MAX != e->_state.upper)
+		/* Single bit is enough when value 0 (or 1/2 when lower is in the
+		 * second quarter and upper is at the maximum) is inside the interval.
+		 */
+		if (RANGE_MIN != e->_state.lower &&
+			(RANGE_MAX != e->_state.upper ||
+			 RANGE_ONE_FOURTH > e->_state.lower))
 		{
 			++e->_pending;
 		}
@@ -179,6 +284,15 @@ void arcd_enc_fin(arcd_enc *const e)
 	}
 }
 
+arcd_cost_t arcd_enc_cost(const arcd_enc *const e)
+{
+	if (e->_estimate)
+	{
+		return e->_cost;
+	}
+	return (e->_cost + e->_pending) << ARCD_COST_FRAC_BITS;
+}
+
 void arcd_dec_init(arcd_dec *const d,
 				   const arcd_getch_t getch, void *const model,
 				   const arcd_input_t input, void *const io)
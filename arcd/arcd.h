@@ -70,6 +70,13 @@ typedef unsigned char arcd_buf_t;
  * overflowing.
  */
 typedef unsigned _arcd_value_t;
+/* Encoded size in bits as fixed point number with ARCD_COST_FRAC_BITS
+ * fractional bits. See arcd_enc_cost().
+ */
+typedef unsigned long long arcd_cost_t;
+
+/* Number of fractional bits in arcd_cost_t values. */
+enum { ARCD_COST_FRAC_BITS = 16 };
 
 /* Number of bits in the bit buffer. */
 #define ARCD_BUF_BITS (8 * sizeof(arcd_buf_t))
@@ -133,11 +140,15 @@ typedef struct _arcd_state
 }
 _arcd_state;
 
-/* Arithmetic encoder. Must be initialized with arcd_enc_init(). */
+/* Arithmetic encoder. Must be initialized with arcd_enc_init() or
+ * arcd_enc_init_estimate().
+ */
 typedef struct arcd_enc
 {
 	_arcd_state _state;
 	unsigned _pending;
+	unsigned _estimate;
+	arcd_cost_t _cost;
 	arcd_getprob_t _getprob;
 	acrd_output_t _output;
 }
@@ -156,11 +167,21 @@ typedef struct arcd_dec
 arcd_dec;
 
 /* Initializes arithmetic encoder. Parameters model and io are for external use
- * and will be passed to getprob() and output() callbacks as is.
+ * and will be passed to getprob() and output() callbacks as is. Output can be
+ * NULL, in that case encoder does a dry run: it does all the same interval
+ * math, but doesn't emit bits and only counts them (see arcd_enc_cost()).
  */
 void arcd_enc_init(arcd_enc *const e,
 				   const arcd_getprob_t getprob, void *const model,
 				   const acrd_output_t output, void *const io);
+/* Initializes arithmetic encoder that only estimates encoded size. It doesn't
+ * maintain coder interval at all, arcd_enc_put() just calls getprob() and adds
+ * -log2((upper - lower) / total) to the cost, using fixed point log table.
+ * Estimate is within a few thousandths of a bit per symbol from the ideal
+ * value and doesn't include 0-2 bits that arcd_enc_fin() adds.
+ */
+void arcd_enc_init_estimate(arcd_enc *const e,
+							const arcd_getprob_t getprob, void *const model);
 /* Encodes one symbol. Will call getprob() callback once. Will call output()
  * callback 0 or more times.
  */
@@ -169,6 +190,14 @@ void arcd_enc_put(arcd_enc *const e, const arcd_char_t ch);
  * times.
  */
 void arcd_enc_fin(arcd_enc *const e);
+/* Returns encoded size in bits (as fixed point number, see
+ * ARCD_COST_FRAC_BITS). For encoders initialized with arcd_enc_init() that is
+ * the number of bits emitted so far (or counted in dry run mode) plus pending
+ * bits. Once arcd_enc_fin() was called, that is exact size of the whole
+ * encoded sequence. For encoders initialized with arcd_enc_init_estimate()
+ * that is the estimated size of symbols encoded so far.
+ */
+arcd_cost_t arcd_enc_cost(const arcd_enc *const e);
 
 /* Initializes arithmetic decoder. Parameters model and io are for external use
  * and will be passed to getch() and input() callbacks as is.
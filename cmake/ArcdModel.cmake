@@ -0,0 +1,61 @@
+# arcd_generate_model(<header> NAME <name>
+#                     MODEL <histogram> | HISTOGRAM <file> | CORPUS <file>
+#                     [SYMBOLS <n>] [TOTAL <n>])
+#
+# Adds custom command that generates <header> with static model <name> using
+# gen_model.py. Relative <header> is placed into the current binary directory.
+# Add <header> to sources of some target to trigger generation.
+#
+# Works in the source tree (include(ArcdModel) with cmake directory in
+# CMAKE_MODULE_PATH) and after find_package(arcd), which includes it from the
+# build or install tree. There gen_model.py is installed next to this file.
+
+include(CMakeParseArguments)
+
+find_program(ARCD_PYTHON_EXECUTABLE NAMES python3 python)
+if(EXISTS ${CMAKE_CURRENT_LIST_DIR}/gen_model.py)
+	set(ARCD_GEN_MODEL ${CMAKE_CURRENT_LIST_DIR}/gen_model.py)
+else()
+	set(ARCD_GEN_MODEL ${CMAKE_CURRENT_LIST_DIR}/../tools/gen_model.py)
+endif()
+
+function(arcd_generate_model header)
+	cmake_parse_arguments(ARG "" "NAME;MODEL;HISTOGRAM;CORPUS;SYMBOLS;TOTAL" ""
+		${ARGN})
+	if(NOT ARG_NAME)
+		message(FATAL_ERROR "arcd_generate_model: NAME is required")
+	endif()
+	if(NOT ARCD_PYTHON_EXECUTABLE)
+		message(FATAL_ERROR "arcd_generate_model: Python is not found")
+	endif()
+	set(args -n ${ARG_NAME})
+	set(depends ${ARCD_GEN_MODEL})
+	if(DEFINED ARG_MODEL)
+		list(APPEND args -m "${ARG_MODEL}")
+	elseif(ARG_HISTOGRAM)
+		get_filename_component(input ${ARG_HISTOGRAM} ABSOLUTE)
+		list(APPEND args -f ${input})
+		list(APPEND depends ${input})
+	elseif(ARG_CORPUS)
+		get_filename_component(input ${ARG_CORPUS} ABSOLUTE)
+		list(APPEND args -c ${input})
+		list(APPEND depends ${input})
+	else()
+		message(FATAL_ERROR
+			"arcd_generate_model: one of MODEL, HISTOGRAM or CORPUS is required")
+	endif()
+	if(ARG_SYMBOLS)
+		list(APPEND args -s ${ARG_SYMBOLS})
+	endif()
+	if(ARG_TOTAL)
+		list(APPEND args -t ${ARG_TOTAL})
+	endif()
+	if(NOT IS_ABSOLUTE ${header})
+		set(header ${CMAKE_CURRENT_BINARY_DIR}/${header})
+	endif()
+	add_custom_command(OUTPUT ${header}
+		COMMAND ${ARCD_PYTHON_EXECUTABLE} ${ARCD_GEN_MODEL} ${args} -o ${header}
+		DEPENDS ${depends}
+		COMMENT "Generating static model ${ARG_NAME}"
+		VERBATIM)
+endfunction()
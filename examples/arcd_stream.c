@@ -1,8 +1,14 @@
+#define _POSIX_C_SOURCE 200112L
+
+#include <stdlib.h>
 #include <string.h>
 #include <stdio.h>
 #include <unistd.h>
 #include <arcd.h>
 #include <adaptive_model.h>
+#include <block_coder.h>
+#include <lz_coder.h>
+#include <thread_pool.h>
 
 void output(const arcd_buf_t buf, const unsigned buf_bits, void *const io)
 {
@@ -20,9 +26,13 @@ unsigned input(arcd_buf_t *const buf, void *const io)
 void usage(FILE *const out)
 {
 	fprintf(out, "Usage:\n");
-	fprintf(out, "    arcd_stream [-e | -d | -h]\n\n");
+	fprintf(out, "    arcd_stream [-e | -d | -h] [-b] [-j THREADS] [-z LEVEL]\n\n");
 	fprintf(out, "-e - encode stdin to stdout\n");
 	fprintf(out, "-d - decode stdin to stdout\n");
+	fprintf(out, "-b - use block-sorting (BWT + MTF + RLE) transform\n");
+	fprintf(out, "-j - number of threads for block-sorting mode\n");
+	fprintf(out, "-z - use LZ77 front end with level from %i to %i\n",
+			LZ_LEVEL_MIN, LZ_LEVEL_MAX);
 	fprintf(out, "-h - help\n\n");
 	fflush(out);
 }
@@ -30,47 +40,305 @@ void usage(FILE *const out)
 typedef unsigned char symbol_t;
 static const arcd_char_t EOS = 1 << (8 * sizeof(symbol_t));
 
-int main(int argc, char *argv[])
+static int encode(FILE *const in, FILE *const out)
 {
-	if (2 != argc)
-	{
-		usage(stderr);
-		return 1;
-	}
-	if (0 == strcmp("-h", argv[1]))
+	adaptive_model model;
+	adaptive_model_create(&model, EOS + 1);
+	arcd_enc enc;
+	arcd_enc_init(&enc, adaptive_model_getprob, &model, output, out);
+	symbol_t sym;
+	while (0 < fread(&sym, sizeof(sym), 1, in))
 	{
-		usage(stdout);
-		return 0;
+		arcd_enc_put(&enc, sym);
 	}
-	FILE *const in = fdopen(dup(fileno(stdin)), "rb");
-	FILE *const out = fdopen(dup(fileno(stdout)), "wb");
+	arcd_enc_put(&enc, EOS);
+	arcd_enc_fin(&enc);
+	adaptive_model_free(&model);
+	return 0;
+}
+
+static int decode(FILE *const in, FILE *const out)
+{
 	adaptive_model model;
 	adaptive_model_create(&model, EOS + 1);
-	if (0 == strcmp("-e", argv[1]))
+	arcd_dec dec;
+	arcd_dec_init(&dec, adaptive_model_getch, &model, input, in);
+	arcd_char_t ch;
+	while (EOS != (ch = arcd_dec_get(&dec)))
+	{
+		const symbol_t sym = (unsigned char)ch;
+		fwrite(&sym, sizeof(sym), 1, out);
+	}
+	adaptive_model_free(&model);
+	return 0;
+}
+
+/* One block processed by a worker thread in block-sorting mode. */
+typedef struct block_job
+{
+	unsigned char header[BLOCK_HEADER_SIZE];
+	unsigned char *data;
+	unsigned size;
+	mem_buffer encoded;
+	int result;
+}
+block_job;
+
+static void block_encode_job(void *const ctx, const unsigned i)
+{
+	block_job *const job = (block_job *)ctx + i;
+	job->encoded.size = 0;
+	block_encode(job->data, job->size, &job->encoded);
+}
+
+static void block_decode_job(void *const ctx, const unsigned i)
+{
+	block_job *const job = (block_job *)ctx + i;
+	job->result = block_decode(job->header, job->encoded.data, job->data);
+}
+
+static int block_stream_encode(FILE *const in, FILE *const out,
+							   const unsigned threads)
+{
+	block_job jobs[threads];
+	for (unsigned i = 0; threads > i; ++i)
+	{
+		jobs[i].data = (unsigned char *)malloc(BLOCK_SIZE_DEFAULT);
+		mem_buffer_init(&jobs[i].encoded);
+	}
+	for (int eof = 0; !eof;)
+	{
+		unsigned count = 0;
+		while (threads > count)
+		{
+			block_job *const job = &jobs[count];
+			job->size = fread(job->data, 1, BLOCK_SIZE_DEFAULT, in);
+			if (0 == job->size)
+			{
+				eof = 1;
+				break;
+			}
+			++count;
+		}
+		if (0 == count)
+		{
+			break;
+		}
+		thread_pool_run(count, count, block_encode_job, jobs);
+		for (unsigned i = 0; count > i; ++i)
+		{
+			fwrite(jobs[i].encoded.data, 1, jobs[i].encoded.size, out);
+		}
+	}
+	for (unsigned i = 0; threads > i; ++i)
+	{
+		mem_buffer_free(&jobs[i].encoded);
+		free(jobs[i].data);
+	}
+	return 0;
+}
+
+static int block_stream_decode(FILE *const in, FILE *const out,
+							   const unsigned threads)
+{
+	block_job jobs[threads];
+	for (unsigned i = 0; threads > i; ++i)
 	{
-		arcd_enc enc;
-		arcd_enc_init(&enc, adaptive_model_getprob, &model, output, out);
-		symbol_t sym;
-		while (0 < fread(&sym, sizeof(sym), 1, in))
+		jobs[i].data = 0;
+		mem_buffer_init(&jobs[i].encoded);
+	}
+	int result = 0;
+	for (int eof = 0; !eof && 0 == result;)
+	{
+		unsigned count = 0;
+		while (threads > count)
+		{
+			block_job *const job = &jobs[count];
+			const size_t n = fread(job->header, 1, BLOCK_HEADER_SIZE, in);
+			if (BLOCK_HEADER_SIZE != n)
+			{
+				result = 0 == n? 0: -1;
+				eof = 1;
+				break;
+			}
+			/* Header is checked before its sizes are used for allocation. */
+			if (0 != block_check(job->header))
+			{
+				result = -1;
+				eof = 1;
+				break;
+			}
+			const unsigned payload_size = block_payload_size(job->header);
+			job->size = block_decoded_size(job->header);
+			unsigned char *const data = (unsigned char *)realloc(job->data,
+					0 < job->size? job->size: 1);
+			if (0 != data)
+			{
+				job->data = data;
+			}
+			job->encoded.size = 0;
+			mem_buffer_reserve(&job->encoded, payload_size);
+			if (0 == data || job->encoded.capacity < payload_size)
+			{
+				result = -1;
+				eof = 1;
+				break;
+			}
+			job->encoded.size = fread(job->encoded.data, 1, payload_size, in);
+			if (payload_size != job->encoded.size)
+			{
+				result = -1;
+				eof = 1;
+				break;
+			}
+			++count;
+		}
+		if (0 == count)
+		{
+			break;
+		}
+		thread_pool_run(count, count, block_decode_job, jobs);
+		for (unsigned i = 0; count > i; ++i)
 		{
-			arcd_enc_put(&enc, sym);
+			if (0 != jobs[i].result)
+			{
+				result = jobs[i].result;
+				break;
+			}
+			fwrite(jobs[i].data, 1, jobs[i].size, out);
 		}
-		arcd_enc_put(&enc, EOS);
-		arcd_enc_fin(&enc);
 	}
-	else if (0 == strcmp("-d", argv[1]))
+	for (unsigned i = 0; threads > i; ++i)
+	{
+		mem_buffer_free(&jobs[i].encoded);
+		free(jobs[i].data);
+	}
+	if (0 != result)
+	{
+		fprintf(stderr, "Error: malformed input\n");
+	}
+	return result;
+}
+
+static void read_all(FILE *const in, mem_buffer *const buf)
+{
+	enum { CHUNK_SIZE = 1 << 16 };
+	size_t n;
+	do
+	{
+		n = fread(mem_buffer_reserve(buf, CHUNK_SIZE), 1, CHUNK_SIZE, in);
+		buf->size += n;
+	}
+	while (0 < n);
+}
+
+static int lz_stream_encode(FILE *const in, FILE *const out,
+							const unsigned level)
+{
+	mem_buffer data;
+	mem_buffer encoded;
+	mem_buffer_init(&data);
+	mem_buffer_init(&encoded);
+	read_all(in, &data);
+	int result = LZ_SIZE_MAX < data.size? -1: 0;
+	if (0 == result)
+	{
+		lz_encode(data.data, data.size, level, &encoded);
+		fwrite(encoded.data, 1, encoded.size, out);
+	}
+	mem_buffer_free(&encoded);
+	mem_buffer_free(&data);
+	if (0 != result)
 	{
-		arcd_dec dec;
-		arcd_dec_init(&dec, adaptive_model_getch, &model, input, in);
-		arcd_char_t ch;
-		while (EOS != (ch = arcd_dec_get(&dec)))
+		fprintf(stderr, "Error: input is too large\n");
+	}
+	return result;
+}
+
+static int lz_stream_decode(FILE *const in, FILE *const out)
+{
+	mem_buffer encoded;
+	mem_buffer_init(&encoded);
+	read_all(in, &encoded);
+	int result = -1;
+	if (0 == lz_check(encoded.data, encoded.size))
+	{
+		const size_t size = lz_decoded_size(encoded.data);
+		unsigned char *const data = (unsigned char *)malloc(0 < size? size: 1);
+		result = lz_decode(encoded.data, encoded.size, data);
+		if (0 == result)
 		{
-			const symbol_t sym = (unsigned char)ch;
-			fwrite(&sym, sizeof(sym), 1, out);
+			fwrite(data, 1, size, out);
 		}
+		free(data);
+	}
+	mem_buffer_free(&encoded);
+	if (0 != result)
+	{
+		fprintf(stderr, "Error: malformed input\n");
+	}
+	return result;
+}
+
+int main(int argc, char *argv[])
+{
+	int mode = 0;
+	int block = 0;
+	unsigned threads = 1;
+	unsigned level = 0;
+	int opt;
+	while (-1 != (opt = getopt(argc, argv, "edhbj:z:")))
+	{
+		switch (opt)
+		{
+		case 'e':
+		case 'd':
+			mode = opt;
+			break;
+		case 'b':
+			block = 1;
+			break;
+		case 'j':
+			threads = (unsigned)atoi(optarg);
+			break;
+		case 'z':
+			level = (unsigned)atoi(optarg);
+			if (LZ_LEVEL_MIN > level || LZ_LEVEL_MAX < level)
+			{
+				usage(stderr);
+				return 1;
+			}
+			break;
+		case 'h':
+			usage(stdout);
+			return 0;
+		default:
+			usage(stderr);
+			return 1;
+		}
+	}
+	if (0 == mode || optind != argc || 0 == threads || 256 < threads ||
+		(block && 0 != level))
+	{
+		usage(stderr);
+		return 1;
+	}
+	FILE *const in = fdopen(dup(fileno(stdin)), "rb");
+	FILE *const out = fdopen(dup(fileno(stdout)), "wb");
+	int result;
+	if ('e' == mode)
+	{
+		result = block? block_stream_encode(in, out, threads):
+				 0 != level? lz_stream_encode(in, out, level):
+				 encode(in, out);
+	}
+	else
+	{
+		result = block? block_stream_decode(in, out, threads):
+				 0 != level? lz_stream_decode(in, out):
+				 decode(in, out);
 	}
-	adaptive_model_free(&model);
 	fclose(in);
 	fclose(out);
-	return 0;
+	return 0 == result? 0: 1;
 }
@@ -0,0 +1,197 @@
+#include <assert.h>
+#include <stdlib.h>
+#include <string.h>
+#include <arcd.h>
+#include "bwt.h"
+#include "freq_table.h"
+#include "block_coder.h"
+
+/* Symbols produced by move-to-front and zero run-length coding. Zero runs are
+ * coded as bijective base-2 numbers with RUNA and RUNB digits. Non-zero
+ * move-to-front index i is coded as i + 1.
+ */
+enum
+{
+	RUNA = 0,
+	RUNB = 1,
+	EOB = 257,
+	SYMBOL_COUNT = 258,
+};
+
+typedef struct mtf_model
+{
+	freq_table table;
+	unsigned short freq[SYMBOL_COUNT];
+}
+mtf_model;
+
+static void mtf_model_init(mtf_model *const m)
+{
+	freq_table_init(&m->table, m->freq, SYMBOL_COUNT);
+}
+
+static void mtf_model_getprob(const arcd_char_t ch, arcd_prob *const prob,
+							  void *const model)
+{
+	freq_table_getprob(&((mtf_model *)model)->table, ch, prob);
+}
+
+static arcd_char_t mtf_model_getch(const arcd_range_t v,
+								   const arcd_range_t range,
+								   arcd_prob *const prob, void *const model)
+{
+	return freq_table_getch(&((mtf_model *)model)->table, v, range, prob);
+}
+
+static void mtf_init(unsigned char *const order)
+{
+	for (unsigned i = 0; 256 > i; ++i)
+	{
+		order[i] = (unsigned char)i;
+	}
+}
+
+static unsigned char mtf_move(unsigned char *const order, const unsigned r)
+{
+	const unsigned char c = order[r];
+	memmove(order + 1, order, r);
+	order[0] = c;
+	return c;
+}
+
+static void put_run(arcd_enc *const enc, unsigned run)
+{
+	while (0 < run)
+	{
+		--run;
+		arcd_enc_put(enc, 1 & run? RUNB: RUNA);
+		run >>= 1;
+	}
+}
+
+void block_encode(const unsigned char *const in, const unsigned size,
+				  mem_buffer *const out)
+{
+	assert(BLOCK_SIZE_MAX >= size);
+	unsigned char *const l = (unsigned char *)malloc(0 < size? size: 1);
+	const unsigned primary = bwt_encode(in, l, size);
+	const size_t header = out->size;
+	mem_buffer_reserve(out, BLOCK_HEADER_SIZE);
+	out->size += BLOCK_HEADER_SIZE;
+	mtf_model model;
+	mtf_model_init(&model);
+	arcd_enc enc;
+	arcd_enc_init(&enc, mtf_model_getprob, &model, mem_output, out);
+	unsigned char order[256];
+	mtf_init(order);
+	unsigned run = 0;
+	for (unsigned i = 0; size > i; ++i)
+	{
+		unsigned r = 0;
+		while (l[i] != order[r])
+		{
+			++r;
+		}
+		if (0 == r)
+		{
+			++run;
+			continue;
+		}
+		mtf_move(order, r);
+		put_run(&enc, run);
+		run = 0;
+		arcd_enc_put(&enc, r + 1);
+	}
+	put_run(&enc, run);
+	arcd_enc_put(&enc, EOB);
+	arcd_enc_fin(&enc);
+	free(l);
+	arcd_buf_t *const p = out->data + header;
+	mem_put_u32(p, size);
+	mem_put_u32(p + 4, primary);
+	mem_put_u32(p + 8, out->size - header - BLOCK_HEADER_SIZE);
+}
+
+unsigned block_decoded_size(const unsigned char *const header)
+{
+	return mem_get_u32(header);
+}
+
+unsigned block_payload_size(const unsigned char *const header)
+{
+	return mem_get_u32(header + 8);
+}
+
+int block_check(const unsigned char *const header)
+{
+	const unsigned size = block_decoded_size(header);
+	if (BLOCK_SIZE_MAX < size)
+	{
+		return -1;
+	}
+	const unsigned payload_max =
+			BLOCK_PAYLOAD_RATIO * (size + 1) + BLOCK_PAYLOAD_SLACK;
+	return payload_max < block_payload_size(header)? -1: 0;
+}
+
+int block_decode(const unsigned char *const header,
+				 const unsigned char *const payload, unsigned char *const out)
+{
+	if (0 != block_check(header))
+	{
+		return -1;
+	}
+	const unsigned size = block_decoded_size(header);
+	unsigned char *const l = (unsigned char *)malloc(0 < size? size: 1);
+	mtf_model model;
+	mtf_model_init(&model);
+	mem_reader reader;
+	mem_reader_init(&reader, payload, block_payload_size(header));
+	arcd_dec dec;
+	arcd_dec_init(&dec, mtf_model_getch, &model, mem_input, &reader);
+	unsigned char order[256];
+	mtf_init(order);
+	unsigned n = 0;
+	unsigned run = 0;
+	unsigned weight = 1;
+	int result = 0;
+	for (;;)
+	{
+		const arcd_char_t ch = arcd_dec_get(&dec);
+		if (RUNA == ch || RUNB == ch)
+		{
+			run += (ch + 1) * weight;
+			weight <<= 1;
+			if (size - n < run)
+			{
+				result = -1;
+				break;
+			}
+			continue;
+		}
+		memset(l + n, order[0], run);
+		n += run;
+		run = 0;
+		weight = 1;
+		if (EOB == ch)
+		{
+			break;
+		}
+		if (size == n)
+		{
+			result = -1;
+			break;
+		}
+		l[n++] = mtf_move(order, ch - 1);
+	}
+	if (0 == result && size != n)
+	{
+		result = -1;
+	}
+	if (0 == result)
+	{
+		result = bwt_decode(l, out, size, mem_get_u32(header + 4));
+	}
+	free(l);
+	return result;
+}
@@ -0,0 +1,51 @@
+#pragma once
+
+#include <stddef.h>
+#include "mem_io.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Block-sorting compressor that uses arithmetic coder as entropy backend.
+ * Each block goes through Burrows-Wheeler transform, move-to-front and zero
+ * run-length coding (bzip2 RUNA/RUNB scheme). Resulting symbols are coded
+ * with adaptive model tuned for move-to-front output. Blocks are independent
+ * from each other and functions keep no global state, so different blocks can
+ * be encoded or decoded concurrently.
+ *
+ * Encoded block (frame) starts with BLOCK_HEADER_SIZE bytes header that holds
+ * decoded size, primary index and payload size (all 32-bit little endian),
+ * followed by the arithmetic coder payload.
+ */
+enum { BLOCK_HEADER_SIZE = 12 };
+enum { BLOCK_SIZE_DEFAULT = 900000 };
+enum { BLOCK_SIZE_MAX = 1 << 26 };
+/* Block of size bytes takes at most size + 1 coder symbols and each symbol
+ * takes at most ARCD_RANGE_BITS + 1 bits, so payload never exceeds
+ * BLOCK_PAYLOAD_RATIO * (size + 1) + BLOCK_PAYLOAD_SLACK bytes.
+ */
+enum { BLOCK_PAYLOAD_RATIO = 3 };
+enum { BLOCK_PAYLOAD_SLACK = 8 };
+
+/* Encodes size bytes from in and appends resulting frame to out. */
+void block_encode(const unsigned char *const in, const unsigned size,
+				  mem_buffer *const out);
+/* Returns decoded size of the frame with specified header. */
+unsigned block_decoded_size(const unsigned char *const header);
+/* Returns payload size of the frame with specified header. */
+unsigned block_payload_size(const unsigned char *const header);
+/* Checks that decoded size and payload size in the header are within limits,
+ * so it is safe to allocate them. Returns 0 if so and non-zero otherwise.
+ */
+int block_check(const unsigned char *const header);
+/* Decodes frame with specified header and payload into out, which must have
+ * room for block_decoded_size() bytes. Returns 0 on success and non-zero if
+ * frame is malformed.
+ */
+int block_decode(const unsigned char *const header,
+				 const unsigned char *const payload, unsigned char *const out);
+
+#ifdef __cplusplus
+}
+#endif
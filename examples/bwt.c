@@ -0,0 +1,258 @@
+#include <assert.h>
+#include <stdlib.h>
+#include "bwt.h"
+
+enum { ALPHABET_SIZE = 256 };
+
+/* Suffix type bits: 1 for S-type suffix, 0 for L-type suffix. */
+#define TYPE_GET(t, i) (1 & ((t)[(i) / 8] >> ((i) % 8)))
+#define TYPE_SET(t, i, b) ((t)[(i) / 8] = (unsigned char)((b)? \
+		(t)[(i) / 8] | 1 << ((i) % 8): (t)[(i) / 8] & ~(1 << ((i) % 8))))
+#define IS_LMS(t, i) (0 < (i) && TYPE_GET(t, i) && !TYPE_GET(t, (i) - 1))
+
+static void get_buckets(const int *const s, int *const bkt,
+						const int n, const int k, const int end)
+{
+	for (int i = 0; k >= i; ++i)
+	{
+		bkt[i] = 0;
+	}
+	for (int i = 0; n > i; ++i)
+	{
+		++bkt[s[i]];
+	}
+	for (int i = 0, sum = 0; k >= i; ++i)
+	{
+		sum += bkt[i];
+		bkt[i] = end? sum: sum - bkt[i];
+	}
+}
+
+static void induce_l(const unsigned char *const t, int *const sa,
+					 const int *const s, int *const bkt,
+					 const int n, const int k)
+{
+	get_buckets(s, bkt, n, k, 0);
+	for (int i = 0; n > i; ++i)
+	{
+		const int j = sa[i] - 1;
+		if (0 <= j && !TYPE_GET(t, j))
+		{
+			sa[bkt[s[j]]++] = j;
+		}
+	}
+}
+
+static void induce_s(const unsigned char *const t, int *const sa,
+					 const int *const s, int *const bkt,
+					 const int n, const int k)
+{
+	get_buckets(s, bkt, n, k, 1);
+	for (int i = n; 0 < i--;)
+	{
+		const int j = sa[i] - 1;
+		if (0 <= j && TYPE_GET(t, j))
+		{
+			sa[--bkt[s[j]]] = j;
+		}
+	}
+}
+
+/* Builds suffix array sa of s. String s has n symbols in [0, k] range and
+ * must end with a unique smallest symbol (sentinel).
+ */
+static void sais(const int *const s, int *const sa, const int n, const int k)
+{
+	unsigned char *const t = (unsigned char *)calloc(n / 8 + 1, 1);
+	int *bkt = (int *)malloc(sizeof(bkt[0]) * (k + 1));
+	TYPE_SET(t, n - 1, 1);
+	if (1 < n)
+	{
+		TYPE_SET(t, n - 2, 0);
+	}
+	for (int i = n - 2; 0 < i--;)
+	{
+		TYPE_SET(t, i, s[i] < s[i + 1] ||
+				 (s[i] == s[i + 1] && TYPE_GET(t, i + 1)));
+	}
+	/* Stage 1: sort LMS substrings. */
+	get_buckets(s, bkt, n, k, 1);
+	for (int i = 0; n > i; ++i)
+	{
+		sa[i] = -1;
+	}
+	for (int i = 1; n > i; ++i)
+	{
+		if (IS_LMS(t, i))
+		{
+			sa[--bkt[s[i]]] = i;
+		}
+	}
+	induce_l(t, sa, s, bkt, n, k);
+	induce_s(t, sa, s, bkt, n, k);
+	/* Compact sorted LMS substrings into the first n1 items and name them. */
+	int n1 = 0;
+	for (int i = 0; n > i; ++i)
+	{
+		if (IS_LMS(t, sa[i]))
+		{
+			sa[n1++] = sa[i];
+		}
+	}
+	for (int i = n1; n > i; ++i)
+	{
+		sa[i] = -1;
+	}
+	int name = 0;
+	for (int i = 0, prev = -1; n1 > i; ++i)
+	{
+		const int pos = sa[i];
+		int diff = 0;
+		for (int d = 0; n > d; ++d)
+		{
+			if (-1 == prev || s[pos + d] != s[prev + d] ||
+				TYPE_GET(t, pos + d) != TYPE_GET(t, prev + d))
+			{
+				diff = 1;
+				break;
+			}
+			if (0 < d && (IS_LMS(t, pos + d) || IS_LMS(t, prev + d)))
+			{
+				break;
+			}
+		}
+		if (diff)
+		{
+			++name;
+			prev = pos;
+		}
+		sa[n1 + pos / 2] = name - 1;
+	}
+	for (int i = n - 1, j = n - 1; n1 <= i; --i)
+	{
+		if (0 <= sa[i])
+		{
+			sa[j--] = sa[i];
+		}
+	}
+	/* Stage 2: sort reduced string, recursively if names are not unique. */
+	int *const sa1 = sa;
+	int *const s1 = sa + n - n1;
+	if (name < n1)
+	{
+		sais(s1, sa1, n1, name - 1);
+	}
+	else
+	{
+		for (int i = 0; n1 > i; ++i)
+		{
+			sa1[s1[i]] = i;
+		}
+	}
+	/* Stage 3: induce the result from sorted LMS suffixes. */
+	get_buckets(s, bkt, n, k, 1);
+	for (int i = 1, j = 0; n > i; ++i)
+	{
+		if (IS_LMS(t, i))
+		{
+			s1[j++] = i;
+		}
+	}
+	for (int i = 0; n1 > i; ++i)
+	{
+		sa1[i] = s1[sa1[i]];
+	}
+	for (int i = n1; n > i; ++i)
+	{
+		sa[i] = -1;
+	}
+	for (int i = n1; 0 < i--;)
+	{
+		const int j = sa[i];
+		sa[i] = -1;
+		sa[--bkt[s[j]]] = j;
+	}
+	induce_l(t, sa, s, bkt, n, k);
+	induce_s(t, sa, s, bkt, n, k);
+	free(bkt);
+	free(t);
+}
+
+unsigned bwt_encode(const unsigned char *const in, unsigned char *const out,
+					const unsigned size)
+{
+	assert(BWT_SIZE_MAX >= size);
+	if (0 == size)
+	{
+		return 0;
+	}
+	/* Shift bytes by one to make room for the sentinel. */
+	const int n = (int)size + 1;
+	int *const s = (int *)malloc(sizeof(s[0]) * n);
+	int *const sa = (int *)malloc(sizeof(sa[0]) * n);
+	for (int i = 0; n - 1 > i; ++i)
+	{
+		s[i] = in[i] + 1;
+	}
+	s[n - 1] = 0;
+	sais(s, sa, n, ALPHABET_SIZE);
+	assert(n - 1 == sa[0]);
+	/* Row 0 is the sentinel suffix, its last column symbol is the last input
+	 * byte. Row that starts at input position 0 has sentinel in the last
+	 * column and is not stored.
+	 */
+	unsigned primary = 0;
+	out[0] = in[size - 1];
+	for (int i = 1, j = 1; n > i; ++i)
+	{
+		if (0 == sa[i])
+		{
+			primary = i;
+		}
+		else
+		{
+			out[j++] = in[sa[i] - 1];
+		}
+	}
+	free(sa);
+	free(s);
+	return primary;
+}
+
+int bwt_decode(const unsigned char *const in, unsigned char *const out,
+			   const unsigned size, const unsigned primary)
+{
+	assert(BWT_SIZE_MAX >= size);
+	if (0 == size)
+	{
+		return 0 == primary? 0: -1;
+	}
+	if (0 == primary || size < primary)
+	{
+		return -1;
+	}
+	/* lf[i] maps row i to the row that starts one symbol earlier. */
+	unsigned *const lf = (unsigned *)malloc(sizeof(lf[0]) * (size + 1));
+	unsigned base[ALPHABET_SIZE] = {0};
+	for (unsigned i = 0; size > i; ++i)
+	{
+		++base[in[i]];
+	}
+	for (unsigned c = 0, sum = 1; ALPHABET_SIZE > c; ++c)
+	{
+		const unsigned count = base[c];
+		base[c] = sum;
+		sum += count;
+	}
+	for (unsigned i = 0, j = 0; size >= i; ++i)
+	{
+		lf[i] = primary == i? 0: base[in[j++]]++;
+	}
+	for (unsigned i = 0, k = size; 0 < k--;)
+	{
+		out[k] = in[i < primary? i: i - 1];
+		i = lf[i];
+	}
+	free(lf);
+	return 0;
+}
@@ -0,0 +1,27 @@
+#pragma once
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Burrows-Wheeler transform of a block of bytes. Input is treated as if it
+ * was terminated with a unique sentinel symbol that is smaller than any byte.
+ * Output has the same size as input, sentinel itself is not stored. Instead
+ * its position in the full (size + 1) last column is returned as primary
+ * index. Suffix array is built with SA-IS in linear time. Functions are
+ * reentrant, so different blocks can be transformed on different threads.
+ */
+enum { BWT_SIZE_MAX = 0x7ffffffe };
+
+/* Returns primary index, which is in [1, size] range when size is not 0. */
+unsigned bwt_encode(const unsigned char *const in, unsigned char *const out,
+					const unsigned size);
+/* Inverse of bwt_encode(). Primary index must be the one returned by
+ * bwt_encode(). Returns 0 on success and non-zero if primary is out of range.
+ */
+int bwt_decode(const unsigned char *const in, unsigned char *const out,
+			   const unsigned size, const unsigned primary);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,321 @@
+#include <assert.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <arcd.h>
+#include "numeric_coder.h"
+#include "sparse_model.h"
+#include "thread_pool.h"
+#include "column_coder.h"
+
+enum { HEADER_SIZE = 8 };
+
+static int64_t field_get(const column_field *const f,
+						 const unsigned char *const record)
+{
+	const unsigned char *const p = record + f->offset;
+	switch (f->size)
+	{
+	case 1:
+	{
+		uint8_t v;
+		memcpy(&v, p, sizeof(v));
+		return f->is_signed? (int8_t)v: (int64_t)v;
+	}
+	case 2:
+	{
+		uint16_t v;
+		memcpy(&v, p, sizeof(v));
+		return f->is_signed? (int16_t)v: (int64_t)v;
+	}
+	case 4:
+	{
+		uint32_t v;
+		memcpy(&v, p, sizeof(v));
+		return f->is_signed? (int32_t)v: (int64_t)v;
+	}
+	default:
+	{
+		int64_t v;
+		memcpy(&v, p, sizeof(v));
+		return v;
+	}
+	}
+}
+
+static void field_set(const column_field *const f, unsigned char *const record,
+					  const int64_t v)
+{
+	unsigned char *const p = record + f->offset;
+	switch (f->size)
+	{
+	case 1:
+	{
+		const uint8_t x = (uint8_t)v;
+		memcpy(p, &x, sizeof(x));
+		break;
+	}
+	case 2:
+	{
+		const uint16_t x = (uint16_t)v;
+		memcpy(p, &x, sizeof(x));
+		break;
+	}
+	case 4:
+	{
+		const uint32_t x = (uint32_t)v;
+		memcpy(p, &x, sizeof(x));
+		break;
+	}
+	default:
+		memcpy(p, &v, sizeof(v));
+		break;
+	}
+}
+
+static int field_valid(const column_field *const f, const size_t record_size)
+{
+	const unsigned size = f->size;
+	if (1 != size && 2 != size && 4 != size && 8 != size)
+	{
+		return 0;
+	}
+	if (record_size < size || record_size - size < f->offset)
+	{
+		return 0;
+	}
+	if (COLUMN_SPARSE == f->model)
+	{
+		return 4 >= size;
+	}
+	return COLUMN_NUMERIC == f->model && NUMERIC_DELTA2 >= f->transform;
+}
+
+typedef struct encode_ctx
+{
+	const column_field *fields;
+	const unsigned char *records;
+	size_t record_size;
+	size_t count;
+	mem_buffer *columns;
+}
+encode_ctx;
+
+static void encode_column(void *const arg, const unsigned i)
+{
+	const encode_ctx *const ctx = (const encode_ctx *)arg;
+	const column_field *const f = &ctx->fields[i];
+	mem_buffer *const out = &ctx->columns[i];
+	const unsigned char *record = ctx->records;
+	arcd_enc e;
+	if (COLUMN_SPARSE == f->model)
+	{
+		sparse_model m;
+		sparse_model_create(&m, COLUMN_SPARSE_CAPACITY);
+		arcd_enc_init(&e, sparse_model_getprob, &m, mem_output, out);
+		for (size_t k = 0; ctx->count > k; ++k, record += ctx->record_size)
+		{
+			sparse_model_put(&e, &m, (arcd_char_t)field_get(f, record));
+		}
+		arcd_enc_fin(&e);
+		sparse_model_free(&m);
+		return;
+	}
+	numeric_model *const m = (numeric_model *)malloc(sizeof(*m));
+	numeric_model_init(m, f->transform);
+	arcd_enc_init(&e, numeric_model_getprob, m, mem_output, out);
+	for (size_t k = 0; ctx->count > k; ++k, record += ctx->record_size)
+	{
+		numeric_model_put(&e, m, field_get(f, record));
+	}
+	arcd_enc_fin(&e);
+	free(m);
+}
+
+void column_encode(const column_field *const fields, const unsigned field_count,
+				   const void *const records, const size_t record_size,
+				   const size_t count, const unsigned threads,
+				   mem_buffer *const out)
+{
+	assert(UINT32_MAX >= count);
+	for (unsigned i = 0; field_count > i; ++i)
+	{
+		assert(field_valid(&fields[i], record_size));
+	}
+	mem_buffer *const columns = (mem_buffer *)malloc(
+			sizeof(columns[0]) * (0 < field_count? field_count: 1));
+	for (unsigned i = 0; field_count > i; ++i)
+	{
+		mem_buffer_init(&columns[i]);
+	}
+	encode_ctx ctx;
+	ctx.fields = fields;
+	ctx.records = (const unsigned char *)records;
+	ctx.record_size = record_size;
+	ctx.count = count;
+	ctx.columns = columns;
+	thread_pool_run(field_count, threads, encode_column, &ctx);
+	const size_t header_size = HEADER_SIZE + 4 * (field_count + 1);
+	arcd_buf_t *const header = mem_buffer_reserve(out, header_size);
+	mem_put_u32(header, count);
+	mem_put_u32(header + 4, field_count);
+	size_t offset = 0;
+	for (unsigned i = 0; field_count >= i; ++i)
+	{
+		mem_put_u32(header + HEADER_SIZE + 4 * i, offset);
+		offset += field_count > i? columns[i].size: 0;
+	}
+	out->size += header_size;
+	for (unsigned i = 0; field_count > i; ++i)
+	{
+		mem_buffer_append(out, columns[i].data, columns[i].size);
+		mem_buffer_free(&columns[i]);
+	}
+	free(columns);
+}
+
+size_t column_decoded_count(const unsigned char *const in, const size_t in_size)
+{
+	return HEADER_SIZE > in_size? 0: mem_get_u32(in);
+}
+
+/* Columns are decoded into private buffers and scattered into records after
+ * all threads are done, so threads don't write to the same cache lines.
+ */
+typedef struct decode_ctx
+{
+	const column_field *fields;
+	const unsigned char *payloads;
+	const unsigned char *offsets;
+	const unsigned *select;
+	int64_t **values;
+	size_t count;
+}
+decode_ctx;
+
+static unsigned column_index(const unsigned *const select, const unsigned i)
+{
+	return 0 != select? select[i]: i;
+}
+
+static void decode_column(void *const arg, const unsigned i)
+{
+	const decode_ctx *const ctx = (const decode_ctx *)arg;
+	const unsigned index = column_index(ctx->select, i);
+	const column_field *const f = &ctx->fields[index];
+	const size_t begin = mem_get_u32(ctx->offsets + 4 * index);
+	const size_t end = mem_get_u32(ctx->offsets + 4 * (index + 1));
+	int64_t *const values = ctx->values[i];
+	mem_reader reader;
+	mem_reader_init(&reader, ctx->payloads + begin, end - begin);
+	arcd_dec d;
+	if (COLUMN_SPARSE == f->model)
+	{
+		sparse_model m;
+		sparse_model_create(&m, COLUMN_SPARSE_CAPACITY);
+		arcd_dec_init(&d, sparse_model_getch, &m, mem_input, &reader);
+		for (size_t k = 0; ctx->count > k; ++k)
+		{
+			values[k] = sparse_model_get(&d, &m);
+		}
+		sparse_model_free(&m);
+		return;
+	}
+	numeric_model *const m = (numeric_model *)malloc(sizeof(*m));
+	numeric_model_init(m, f->transform);
+	arcd_dec_init(&d, numeric_model_getch, m, mem_input, &reader);
+	for (size_t k = 0; ctx->count > k; ++k)
+	{
+		values[k] = numeric_model_get(&d, m);
+	}
+	free(m);
+}
+
+int column_decode(const column_field *const fields, const unsigned field_count,
+				  const unsigned char *const in, const size_t in_size,
+				  const unsigned *const select, const unsigned select_count,
+				  void *const records, const size_t record_size,
+				  const unsigned threads)
+{
+	if (HEADER_SIZE > in_size || field_count != mem_get_u32(in + 4))
+	{
+		return -1;
+	}
+	const size_t header_size = HEADER_SIZE + 4 * (field_count + 1);
+	if (header_size > in_size)
+	{
+		return -1;
+	}
+	const unsigned char *const offsets = in + HEADER_SIZE;
+	for (unsigned i = 0; field_count > i; ++i)
+	{
+		if (!field_valid(&fields[i], record_size) ||
+			mem_get_u32(offsets + 4 * i) > mem_get_u32(offsets + 4 * (i + 1)))
+		{
+			return -1;
+		}
+	}
+	if (mem_get_u32(offsets + 4 * field_count) > in_size - header_size)
+	{
+		return -1;
+	}
+	for (unsigned i = 0; 0 != select && select_count > i; ++i)
+	{
+		if (field_count <= select[i])
+		{
+			return -1;
+		}
+		for (unsigned k = 0; i > k; ++k)
+		{
+			if (select[k] == select[i])
+			{
+				return -1;
+			}
+		}
+	}
+	const unsigned column_count = 0 != select? select_count: field_count;
+	const size_t count = mem_get_u32(in);
+	int64_t **const values = (int64_t **)calloc(
+			0 < column_count? column_count: 1, sizeof(values[0]));
+	if (0 == values)
+	{
+		return -1;
+	}
+	int result = 0;
+	for (unsigned i = 0; column_count > i; ++i)
+	{
+		values[i] = (int64_t *)malloc(
+				sizeof(values[i][0]) * (0 < count? count: 1));
+		if (0 == values[i])
+		{
+			result = -1;
+			break;
+		}
+	}
+	if (0 == result)
+	{
+		decode_ctx ctx;
+		ctx.fields = fields;
+		ctx.payloads = in + header_size;
+		ctx.offsets = offsets;
+		ctx.select = select;
+		ctx.values = values;
+		ctx.count = count;
+		thread_pool_run(column_count, threads, decode_column, &ctx);
+		unsigned char *record = (unsigned char *)records;
+		for (size_t k = 0; count > k; ++k, record += record_size)
+		{
+			for (unsigned i = 0; column_count > i; ++i)
+			{
+				field_set(&fields[column_index(select, i)], record,
+						  values[i][k]);
+			}
+		}
+	}
+	for (unsigned i = 0; column_count > i; ++i)
+	{
+		free(values[i]);
+	}
+	free(values);
+	return result;
+}
@@ -0,0 +1,66 @@
+#pragma once
+
+#include <stddef.h>
+#include "mem_io.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Columnar coder for arrays of records (structs). Schema describes where each
+ * integer field lives in the record and which model codes it. Every field is
+ * split into its own column that is coded with its own arcd_enc and model, so
+ * fields don't mix statistics and columns can be coded concurrently on a
+ * thread pool. Decoder can materialize only selected columns.
+ *
+ * Encoded data starts with record count and column count, followed by
+ * column count + 1 offsets of column payloads (relative to the end of the
+ * offsets table, last one is the end of the last payload). All values are
+ * 32-bit little endian.
+ */
+enum
+{
+	/* numeric_model with delta transform set in column_field::transform. */
+	COLUMN_NUMERIC,
+	/* sparse_model, for identifiers and categories up to 4 bytes. */
+	COLUMN_SPARSE,
+};
+
+enum { COLUMN_SPARSE_CAPACITY = 1024 };
+
+typedef struct column_field
+{
+	/* Offset of the field in the record. */
+	size_t offset;
+	/* Field size: 1, 2, 4 or 8 bytes. */
+	unsigned size;
+	unsigned is_signed;
+	unsigned model;
+	unsigned transform;
+}
+column_field;
+
+/* Encodes count records of record_size bytes each and appends result to out.
+ * Uses up to threads threads.
+ */
+void column_encode(const column_field *const fields, const unsigned field_count,
+				   const void *const records, const size_t record_size,
+				   const size_t count, const unsigned threads,
+				   mem_buffer *const out);
+/* Returns number of records in encoded data or 0 if header is malformed. */
+size_t column_decoded_count(const unsigned char *const in, const size_t in_size);
+/* Decodes fields listed in select (indices into fields, all fields when select
+ * is NULL) into records, which must have room for column_decoded_count()
+ * records of record_size bytes. Other fields are left untouched. Uses up to
+ * threads threads. Returns 0 on success and non-zero if data is malformed or
+ * select lists the same field twice.
+ */
+int column_decode(const column_field *const fields, const unsigned field_count,
+				  const unsigned char *const in, const size_t in_size,
+				  const unsigned *const select, const unsigned select_count,
+				  void *const records, const size_t record_size,
+				  const unsigned threads);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,121 @@
+#include <assert.h>
+#include "freq_table.h"
+
+static void freq_table_update(freq_table *const t, const arcd_char_t ch)
+{
+	t->freq[ch] += FREQ_TABLE_INC;
+	t->total += FREQ_TABLE_INC;
+	if (ARCD_FREQ_MAX >= t->total)
+	{
+		return;
+	}
+	t->total = 0;
+	for (unsigned i = 0; t->count > i; ++i)
+	{
+		t->freq[i] = (t->freq[i] + 1) / 2;
+		t->total += t->freq[i];
+	}
+}
+
+void freq_table_init(freq_table *const t, unsigned short *const freq,
+					 const unsigned count)
+{
+	assert(0 < count && FREQ_TABLE_COUNT_MAX >= count);
+	t->freq = freq;
+	t->count = count;
+	t->total = count;
+	for (unsigned i = 0; count > i; ++i)
+	{
+		freq[i] = 1;
+	}
+}
+
+void freq_table_getprob(freq_table *const t, const arcd_char_t ch,
+						arcd_prob *const prob)
+{
+	assert(t->count > ch);
+	arcd_freq_t lower = 0;
+	for (unsigned i = 0; ch > i; ++i)
+	{
+		lower += t->freq[i];
+	}
+	prob->lower = lower;
+	prob->upper = lower + t->freq[ch];
+	prob->total = t->total;
+	freq_table_update(t, ch);
+}
+
+arcd_char_t freq_table_getch(freq_table *const t, const arcd_range_t v,
+							 const arcd_range_t range, arcd_prob *const prob)
+{
+	const arcd_freq_t freq = arcd_freq_scale(v, range, t->total);
+	arcd_freq_t lower = 0;
+	for (unsigned i = 0; t->count > i; ++i)
+	{
+		const arcd_freq_t upper = lower + t->freq[i];
+		if (freq < upper)
+		{
+			prob->lower = lower;
+			prob->upper = upper;
+			prob->total = t->total;
+			freq_table_update(t, i);
+			return i;
+		}
+		lower = upper;
+	}
+	assert(!"Bad range");
+	return -1;
+}
+
+void raw_bits_getprob(const unsigned bits, const arcd_char_t ch,
+					  arcd_prob *const prob)
+{
+	assert(0 < bits && ARCD_FREQ_BITS >= bits && (1u << bits) > ch);
+	prob->lower = ch;
+	prob->upper = ch + 1;
+	prob->total = 1u << bits;
+}
+
+arcd_char_t raw_bits_getch(const unsigned bits, const arcd_range_t v,
+						   const arcd_range_t range, arcd_prob *const prob)
+{
+	const arcd_freq_t total = 1u << bits;
+	const arcd_freq_t freq = arcd_freq_scale(v, range, total);
+	prob->lower = freq;
+	prob->upper = freq + 1;
+	prob->total = total;
+	return freq;
+}
+
+void freq_model_getprob(const arcd_char_t ch, arcd_prob *const prob,
+						void *const model)
+{
+	freq_model *const m = (freq_model *)model;
+	if (0 == m->table)
+	{
+		raw_bits_getprob(m->bits, ch, prob);
+		return;
+	}
+	freq_table_getprob(m->table, ch, prob);
+}
+
+arcd_char_t freq_model_getch(const arcd_range_t v, const arcd_range_t range,
+							 arcd_prob *const prob, void *const model)
+{
+	freq_model *const m = (freq_model *)model;
+	if (0 == m->table)
+	{
+		return raw_bits_getch(m->bits, v, range, prob);
+	}
+	return freq_table_getch(m->table, v, range, prob);
+}
+
+unsigned bit_length(uint64_t v)
+{
+	unsigned length = 0;
+	for (; 0 != v; v >>= 1)
+	{
+		++length;
+	}
+	return length;
+}
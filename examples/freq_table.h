@@ -0,0 +1,73 @@
+#pragma once
+
+#include <stdint.h>
+#include <arcd.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Building blocks shared by example models: adaptive frequency table for
+ * small alphabets, raw bits coding and selector between the two.
+ */
+
+/* Data coded by example models is dominated by few symbols, but distribution
+ * changes quickly from one part of the input to another. So tables use large
+ * increment (and therefore frequent rescaling) to adapt fast.
+ */
+enum { FREQ_TABLE_INC = 24 };
+/* Tables with more symbols can't keep total within ARCD_FREQ_MAX. */
+enum { FREQ_TABLE_COUNT_MAX = ARCD_FREQ_MAX / 2 };
+
+/* Adaptive frequency table. Frequencies are stored in external array, so
+ * tables of different sizes can live in one struct. Every symbol starts with
+ * frequency 1, coded symbol gets FREQ_TABLE_INC more and all frequencies are
+ * halved (rounding up) when total exceeds ARCD_FREQ_MAX.
+ */
+typedef struct freq_table
+{
+	unsigned short *freq;
+	unsigned count;
+	unsigned total;
+}
+freq_table;
+
+void freq_table_init(freq_table *const t, unsigned short *const freq,
+					 const unsigned count);
+/* Fills prob for symbol ch and updates the table. */
+void freq_table_getprob(freq_table *const t, const arcd_char_t ch,
+						arcd_prob *const prob);
+/* Finds symbol for v in range, fills its prob and updates the table. */
+arcd_char_t freq_table_getch(freq_table *const t, const arcd_range_t v,
+							 const arcd_range_t range, arcd_prob *const prob);
+
+/* Uniform distribution over bits wide values (bits from 1 to ARCD_FREQ_BITS),
+ * for bits that are not worth modeling.
+ */
+void raw_bits_getprob(const unsigned bits, const arcd_char_t ch,
+					  arcd_prob *const prob);
+arcd_char_t raw_bits_getch(const unsigned bits, const arcd_range_t v,
+						   const arcd_range_t range, arcd_prob *const prob);
+
+/* Model that codes with the selected table or, when table is NULL, with raw
+ * bits. Coders that use several tables switch table before every
+ * arcd_enc_put() and arcd_dec_get().
+ */
+typedef struct freq_model
+{
+	freq_table *table;
+	unsigned bits;
+}
+freq_model;
+
+void freq_model_getprob(const arcd_char_t ch, arcd_prob *const prob,
+						void *const model);
+arcd_char_t freq_model_getch(const arcd_range_t v, const arcd_range_t range,
+							 arcd_prob *const prob, void *const model);
+
+/* Returns number of significant bits in v (0 for 0). */
+unsigned bit_length(uint64_t v);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,474 @@
+#include <assert.h>
+#include <stdlib.h>
+#include <arcd.h>
+#include "freq_table.h"
+#include "lz_coder.h"
+
+enum
+{
+	KIND_LITERAL,
+	KIND_MATCH,
+	KIND_REP,
+	KIND_COUNT,
+};
+
+enum { MATCH_MIN = 3 };
+enum { MATCH_MAX = MATCH_MIN + 511 };
+/* Length l = len - MATCH_MIN below 8 is coded by its slot alone. Larger
+ * lengths are coded as slot (bit length of l) and l bits below the top one.
+ */
+enum { LENGTH_SLOTS = 14 };
+/* Distance d = offset - 1 below 4 is coded by its slot alone. Larger distances
+ * are coded as slot (bit length of d and the bit below the top one) and
+ * remaining bits, four lowest of which go through an adaptive model.
+ */
+enum { OFFSET_BITS_MAX = 24 };
+enum { OFFSET_SLOTS = 2 * OFFSET_BITS_MAX };
+enum { ALIGN_BITS = 4 };
+/* Literal context is the top LITERAL_CONTEXT_BITS bits of previous byte. */
+enum { LITERAL_CONTEXT_BITS = 3 };
+enum { UNIFORM_CHUNK_BITS = 8 };
+
+enum { HASH_BITS = 16 };
+
+typedef struct lz_level
+{
+	unsigned window_bits;
+	unsigned chain;
+	unsigned nice;
+	unsigned lazy;
+}
+lz_level;
+
+static const lz_level c_levels[LZ_LEVEL_MAX] =
+{
+	{16, 2, 16, 0},
+	{17, 4, 24, 0},
+	{18, 8, 32, 0},
+	{19, 16, 48, 1},
+	{20, 32, 64, 1},
+	{21, 64, 128, 1},
+	{22, 128, 192, 1},
+	{22, 512, 256, 1},
+	{22, 2048, MATCH_MAX, 1},
+};
+
+/* All tables used by coder. Only one table is active at a time, coder selects
+ * it before coding every symbol.
+ */
+typedef struct lz_model
+{
+	freq_model coder;
+	freq_table kind[KIND_COUNT];
+	freq_table literal[1 << LITERAL_CONTEXT_BITS];
+	freq_table length[2];
+	freq_table offset;
+	freq_table align;
+	unsigned short kind_freq[KIND_COUNT][KIND_COUNT];
+	unsigned short literal_freq[1 << LITERAL_CONTEXT_BITS][256];
+	unsigned short length_freq[2][LENGTH_SLOTS];
+	unsigned short offset_freq[OFFSET_SLOTS];
+	unsigned short align_freq[1 << ALIGN_BITS];
+}
+lz_model;
+
+static void model_init(lz_model *const m)
+{
+	m->coder.table = 0;
+	m->coder.bits = 0;
+	for (unsigned i = 0; KIND_COUNT > i; ++i)
+	{
+		freq_table_init(&m->kind[i], m->kind_freq[i], KIND_COUNT);
+	}
+	for (unsigned i = 0; (1 << LITERAL_CONTEXT_BITS) > i; ++i)
+	{
+		freq_table_init(&m->literal[i], m->literal_freq[i], 256);
+	}
+	for (unsigned i = 0; 2 > i; ++i)
+	{
+		freq_table_init(&m->length[i], m->length_freq[i], LENGTH_SLOTS);
+	}
+	freq_table_init(&m->offset, m->offset_freq, OFFSET_SLOTS);
+	freq_table_init(&m->align, m->align_freq, 1 << ALIGN_BITS);
+}
+
+static void put(arcd_enc *const e, lz_model *const m, freq_table *const t,
+				const unsigned ch)
+{
+	m->coder.table = t;
+	arcd_enc_put(e, ch);
+}
+
+static unsigned get(arcd_dec *const d, lz_model *const m, freq_table *const t)
+{
+	m->coder.table = t;
+	return arcd_dec_get(d);
+}
+
+static void put_bits(arcd_enc *const e, lz_model *const m,
+					 const size_t v, unsigned bits)
+{
+	m->coder.table = 0;
+	while (0 < bits)
+	{
+		m->coder.bits = UNIFORM_CHUNK_BITS < bits? UNIFORM_CHUNK_BITS: bits;
+		bits -= m->coder.bits;
+		arcd_enc_put(e, (v >> bits) & ((1u << m->coder.bits) - 1));
+	}
+}
+
+static size_t get_bits(arcd_dec *const d, lz_model *const m, unsigned bits)
+{
+	size_t v = 0;
+	m->coder.table = 0;
+	while (0 < bits)
+	{
+		m->coder.bits = UNIFORM_CHUNK_BITS < bits? UNIFORM_CHUNK_BITS: bits;
+		bits -= m->coder.bits;
+		v |= (size_t)arcd_dec_get(d) << bits;
+	}
+	return v;
+}
+
+static void put_length(arcd_enc *const e, lz_model *const m,
+					   const unsigned kind, const size_t len)
+{
+	assert(MATCH_MIN <= len && MATCH_MAX >= len);
+	const size_t l = len - MATCH_MIN;
+	freq_table *const t = &m->length[KIND_REP == kind];
+	if (8 > l)
+	{
+		put(e, m, t, l);
+		return;
+	}
+	const unsigned b = bit_length(l);
+	put(e, m, t, b + 4);
+	put_bits(e, m, l, b - 1);
+}
+
+static size_t get_length(arcd_dec *const d, lz_model *const m,
+						 const unsigned kind)
+{
+	const unsigned slot = get(d, m, &m->length[KIND_REP == kind]);
+	if (8 > slot)
+	{
+		return MATCH_MIN + slot;
+	}
+	const unsigned b = slot - 4;
+	return MATCH_MIN + ((size_t)1 << (b - 1) | get_bits(d, m, b - 1));
+}
+
+static void put_offset(arcd_enc *const e, lz_model *const m,
+					   const size_t offset)
+{
+	const size_t dist = offset - 1;
+	if (4 > dist)
+	{
+		put(e, m, &m->offset, dist);
+		return;
+	}
+	const unsigned b = bit_length(dist);
+	assert(OFFSET_BITS_MAX >= b);
+	put(e, m, &m->offset, 2 * (b - 1) + (1 & (dist >> (b - 2))));
+	const unsigned extra = b - 2;
+	if (ALIGN_BITS > extra)
+	{
+		put_bits(e, m, dist, extra);
+		return;
+	}
+	put_bits(e, m, dist >> ALIGN_BITS, extra - ALIGN_BITS);
+	put(e, m, &m->align, dist & ((1u << ALIGN_BITS) - 1));
+}
+
+static size_t get_offset(arcd_dec *const d, lz_model *const m)
+{
+	const unsigned slot = get(d, m, &m->offset);
+	if (4 > slot)
+	{
+		return slot + 1;
+	}
+	const unsigned extra = slot / 2 - 1;
+	const size_t base = (size_t)(2 | (1 & slot)) << extra;
+	if (ALIGN_BITS > extra)
+	{
+		return base + get_bits(d, m, extra) + 1;
+	}
+	const size_t high = get_bits(d, m, extra - ALIGN_BITS) << ALIGN_BITS;
+	return base + high + get(d, m, &m->align) + 1;
+}
+
+static freq_table *literal_table(lz_model *const m,
+							   const unsigned char *const p, const size_t pos)
+{
+	const unsigned ctx = 0 < pos? p[pos - 1] >> (8 - LITERAL_CONTEXT_BITS): 0;
+	return &m->literal[ctx];
+}
+
+/* Hash chains match finder. head[] holds the last position (plus one) with
+ * the given hash of three bytes, prev[] links positions within the window.
+ */
+typedef struct lz_finder
+{
+	const unsigned char *in;
+	size_t size;
+	size_t window;
+	size_t mask;
+	unsigned chain;
+	unsigned nice;
+	size_t *head;
+	size_t *prev;
+	size_t inserted;
+}
+lz_finder;
+
+static unsigned hash3(const unsigned char *const p)
+{
+	const unsigned v = (unsigned)p[0] | (unsigned)p[1] << 8 |
+					   (unsigned)p[2] << 16;
+	return (v * 2654435761u) >> (32 - HASH_BITS) & ((1u << HASH_BITS) - 1);
+}
+
+static void finder_init(lz_finder *const f, const unsigned char *const in,
+						const size_t size, const lz_level *const level)
+{
+	size_t window = (size_t)1 << level->window_bits;
+	size_t chain_size = 1;
+	while (chain_size < size && chain_size < window)
+	{
+		chain_size *= 2;
+	}
+	f->in = in;
+	f->size = size;
+	f->window = window - 1;
+	f->mask = chain_size - 1;
+	f->chain = level->chain;
+	f->nice = level->nice;
+	f->head = (size_t *)calloc((size_t)1 << HASH_BITS, sizeof(f->head[0]));
+	f->prev = (size_t *)calloc(chain_size, sizeof(f->prev[0]));
+	f->inserted = 0;
+}
+
+static void finder_free(lz_finder *const f)
+{
+	free(f->prev);
+	free(f->head);
+}
+
+/* Inserts all positions before end into hash chains. */
+static void finder_insert(lz_finder *const f, const size_t end)
+{
+	for (; end > f->inserted && f->size - f->inserted >= MATCH_MIN;
+		 ++f->inserted)
+	{
+		const unsigned h = hash3(f->in + f->inserted);
+		f->prev[f->inserted & f->mask] = f->head[h];
+		f->head[h] = f->inserted + 1;
+	}
+}
+
+static size_t match_length(const lz_finder *const f, const size_t pos,
+						   const size_t offset, size_t max)
+{
+	const unsigned char *const a = f->in + pos;
+	const unsigned char *const b = a - offset;
+	size_t len = 0;
+	while (max > len && a[len] == b[len])
+	{
+		++len;
+	}
+	return len;
+}
+
+/* Finds the longest match at pos. Returns its length (0 if none) and stores
+ * its offset.
+ */
+static size_t finder_find(lz_finder *const f, const size_t pos,
+						  size_t *const offset)
+{
+	finder_insert(f, pos);
+	size_t max = f->size - pos;
+	if (MATCH_MAX < max)
+	{
+		max = MATCH_MAX;
+	}
+	if (MATCH_MIN > max)
+	{
+		return 0;
+	}
+	size_t best = 0;
+	size_t cand = f->head[hash3(f->in + pos)];
+	for (unsigned chain = f->chain; 0 < chain-- && 0 != cand;)
+	{
+		const size_t c = cand - 1;
+		if (pos - c > f->window || pos - c > f->mask)
+		{
+			break;
+		}
+		if (f->in[c + best] == f->in[pos + best])
+		{
+			const size_t len = match_length(f, pos, pos - c, max);
+			if (best < len)
+			{
+				best = len;
+				*offset = pos - c;
+				if (f->nice <= len || max == len)
+				{
+					break;
+				}
+			}
+		}
+		cand = f->prev[c & f->mask];
+	}
+	return MATCH_MIN <= best? best: 0;
+}
+
+void lz_encode(const unsigned char *const in, const size_t size,
+			   const unsigned level, mem_buffer *const out)
+{
+	assert(LZ_LEVEL_MIN <= level && LZ_LEVEL_MAX >= level);
+	assert(LZ_SIZE_MAX >= size);
+	const lz_level *const lv = &c_levels[level - LZ_LEVEL_MIN];
+	const size_t header = out->size;
+	mem_buffer_reserve(out, LZ_HEADER_SIZE);
+	out->size += LZ_HEADER_SIZE;
+	lz_model *const m = (lz_model *)malloc(sizeof(*m));
+	model_init(m);
+	lz_finder f;
+	finder_init(&f, in, size, lv);
+	arcd_enc e;
+	arcd_enc_init(&e, freq_model_getprob, &m->coder, mem_output, out);
+	unsigned kind = KIND_LITERAL;
+	size_t rep = 0;
+	size_t offset = 0;
+	size_t len = finder_find(&f, 0, &offset);
+	for (size_t pos = 0; size > pos;)
+	{
+		size_t rep_len = 0;
+		if (0 != rep && pos >= rep)
+		{
+			const size_t max = f.size - pos;
+			rep_len = match_length(&f, pos, rep, MATCH_MAX < max? MATCH_MAX: max);
+		}
+		/* Lazy matching: prefer a literal when the next position has a
+		 * longer match.
+		 */
+		const int lazy = lv->lazy && 0 < len && f.nice > len;
+		size_t next_offset = 0;
+		size_t next_len = 0;
+		if (lazy)
+		{
+			next_len = finder_find(&f, pos + 1, &next_offset);
+		}
+		if (MATCH_MIN <= rep_len && rep_len + 1 >= len && rep_len >= next_len)
+		{
+			put(&e, m, &m->kind[kind], KIND_REP);
+			kind = KIND_REP;
+			put_length(&e, m, kind, rep_len);
+			len = rep_len;
+		}
+		else if (0 < len && len >= next_len + (0 < next_len))
+		{
+			put(&e, m, &m->kind[kind], KIND_MATCH);
+			kind = KIND_MATCH;
+			put_length(&e, m, kind, len);
+			put_offset(&e, m, offset);
+			rep = offset;
+		}
+		else
+		{
+			put(&e, m, &m->kind[kind], KIND_LITERAL);
+			kind = KIND_LITERAL;
+			put(&e, m, literal_table(m, in, pos), in[pos]);
+			++pos;
+			if (lazy)
+			{
+				len = next_len;
+				offset = next_offset;
+			}
+			else
+			{
+				len = finder_find(&f, pos, &offset);
+			}
+			continue;
+		}
+		pos += len;
+		len = finder_find(&f, pos, &offset);
+	}
+	arcd_enc_fin(&e);
+	finder_free(&f);
+	free(m);
+	arcd_buf_t *const p = out->data + header;
+	mem_put_u32(p, size);
+	mem_put_u32(p + 4, out->size - header - LZ_HEADER_SIZE);
+}
+
+size_t lz_decoded_size(const unsigned char *const header)
+{
+	return mem_get_u32(header);
+}
+
+size_t lz_payload_size(const unsigned char *const header)
+{
+	return mem_get_u32(header + 4);
+}
+
+int lz_check(const unsigned char *const in, const size_t in_size)
+{
+	if (LZ_HEADER_SIZE > in_size)
+	{
+		return -1;
+	}
+	const size_t size = lz_decoded_size(in);
+	const size_t payload_size = lz_payload_size(in);
+	if (in_size - LZ_HEADER_SIZE < payload_size || LZ_SIZE_MAX < size)
+	{
+		return -1;
+	}
+	return payload_size < size / LZ_RATIO_MAX? -1: 0;
+}
+
+int lz_decode(const unsigned char *const in, const size_t in_size,
+			  unsigned char *const out)
+{
+	if (0 != lz_check(in, in_size))
+	{
+		return -1;
+	}
+	const size_t size = lz_decoded_size(in);
+	lz_model *const m = (lz_model *)malloc(sizeof(*m));
+	model_init(m);
+	mem_reader reader;
+	mem_reader_init(&reader, in + LZ_HEADER_SIZE, lz_payload_size(in));
+	arcd_dec d;
+	arcd_dec_init(&d, freq_model_getch, &m->coder, mem_input, &reader);
+	unsigned kind = KIND_LITERAL;
+	size_t rep = 0;
+	int result = 0;
+	for (size_t pos = 0; size > pos;)
+	{
+		kind = get(&d, m, &m->kind[kind]);
+		if (KIND_LITERAL == kind)
+		{
+			out[pos] = (unsigned char)get(&d, m, literal_table(m, out, pos));
+			++pos;
+			continue;
+		}
+		const size_t len = get_length(&d, m, kind);
+		if (KIND_MATCH == kind)
+		{
+			rep = get_offset(&d, m);
+		}
+		if (0 == rep || pos < rep || size - pos < len)
+		{
+			result = -1;
+			break;
+		}
+		/* Byte by byte, since source and destination can overlap. */
+		for (const size_t end = pos + len; end > pos; ++pos)
+		{
+			out[pos] = out[pos - rep];
+		}
+	}
+	free(m);
+	return result;
+}
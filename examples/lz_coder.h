@@ -0,0 +1,55 @@
+#pragma once
+
+#include <stddef.h>
+#include "mem_io.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* LZ77 compressor that uses arithmetic coder as entropy backend. Matches are
+ * found with hash chains over a sliding window. Each token is either a
+ * literal, a match (length and offset) or a repeated match (length only,
+ * offset of the previous match). Token kinds, literals, lengths and offsets
+ * are coded with separate adaptive models. Level (from LZ_LEVEL_MIN to
+ * LZ_LEVEL_MAX) trades speed for ratio by changing window size, hash chain
+ * depth and lazy matching.
+ *
+ * Encoded data starts with LZ_HEADER_SIZE bytes header that holds decoded size
+ * and payload size (both 32-bit little endian), followed by the arithmetic
+ * coder payload.
+ */
+enum { LZ_HEADER_SIZE = 8 };
+enum { LZ_LEVEL_MIN = 1 };
+enum { LZ_LEVEL_MAX = 9 };
+enum { LZ_LEVEL_DEFAULT = 6 };
+enum { LZ_SIZE_MAX = 0x7fffffff };
+/* Upper bound of decoded bytes per payload byte. Lengths above 10 bytes take
+ * raw bits, so the best case is a 10 bytes repeated match with the most
+ * probable kind and length, which still takes more than 6.6e-4 bits (about
+ * 121000 decoded bytes per payload byte). Frames above it are rejected.
+ */
+enum { LZ_RATIO_MAX = 1 << 17 };
+
+/* Encodes size bytes from in and appends result to out. */
+void lz_encode(const unsigned char *const in, const size_t size,
+			   const unsigned level, mem_buffer *const out);
+/* Returns decoded size of the data with specified header. */
+size_t lz_decoded_size(const unsigned char *const header);
+/* Returns payload size of the data with specified header. */
+size_t lz_payload_size(const unsigned char *const header);
+/* Checks that in_size bytes from in hold the whole header and payload and that
+ * decoded size is plausible for the payload size, so it is safe to allocate
+ * lz_decoded_size() bytes. Returns 0 if so and non-zero otherwise.
+ */
+int lz_check(const unsigned char *const in, const size_t in_size);
+/* Decodes in_size bytes from in (including header) into out, which must have
+ * room for lz_decoded_size() bytes. Matches are copied within out directly.
+ * Returns 0 on success and non-zero if data is malformed.
+ */
+int lz_decode(const unsigned char *const in, const size_t in_size,
+			  unsigned char *const out);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,92 @@
+#include <stdlib.h>
+#include <string.h>
+#include "mem_io.h"
+
+void mem_buffer_init(mem_buffer *const b)
+{
+	b->data = 0;
+	b->size = 0;
+	b->capacity = 0;
+}
+
+void mem_buffer_free(mem_buffer *const b)
+{
+	free(b->data);
+}
+
+arcd_buf_t *mem_buffer_reserve(mem_buffer *const b, const size_t size)
+{
+	if (b->capacity - b->size < size)
+	{
+		size_t capacity = 2 * b->capacity;
+		if (b->size + size > capacity)
+		{
+			capacity = b->size + size;
+		}
+		arcd_buf_t *const data = (arcd_buf_t *)realloc(b->data,
+				sizeof(b->data[0]) * capacity);
+		if (0 == data)
+		{
+			return 0;
+		}
+		b->data = data;
+		b->capacity = capacity;
+	}
+	return b->data + b->size;
+}
+
+void mem_buffer_append(mem_buffer *const b, const void *const data,
+					   const size_t size)
+{
+	if (0 == size)
+	{
+		return;
+	}
+	memcpy(mem_buffer_reserve(b, size), data, size);
+	b->size += size;
+}
+
+void mem_output(const arcd_buf_t buf, const unsigned buf_bits, void *const io)
+{
+	(void)buf_bits;
+	mem_buffer *const b = (mem_buffer *)io;
+	*mem_buffer_reserve(b, 1) = buf;
+	++b->size;
+}
+
+void mem_reader_init(mem_reader *const r, const void *const data,
+					 const size_t size)
+{
+	r->data = (const arcd_buf_t *)data;
+	r->size = size;
+	r->pos = 0;
+}
+
+unsigned mem_input(arcd_buf_t *const buf, void *const io)
+{
+	mem_reader *const r = (mem_reader *)io;
+	if (r->size <= r->pos)
+	{
+		return 0;
+	}
+	*buf = r->data[r->pos++];
+	return ARCD_BUF_BITS;
+}
+
+void mem_put_u32(arcd_buf_t *const p, const unsigned long v)
+{
+	for (unsigned i = 0; 4 > i; ++i)
+	{
+		p[i] = (arcd_buf_t)(v >> (8 * i));
+	}
+}
+
+unsigned long mem_get_u32(const arcd_buf_t *const p)
+{
+	unsigned long v = 0;
+	for (unsigned i = 4; 0 < i--;)
+	{
+		v = v << 8 | p[i];
+	}
+	return v;
+}
@@ -0,0 +1,53 @@
+#pragma once
+
+#include <stddef.h>
+#include <arcd.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Growable memory buffer. Can be used as io parameter of arcd_enc with
+ * mem_output() callback.
+ */
+typedef struct mem_buffer
+{
+	arcd_buf_t *data;
+	size_t size;
+	size_t capacity;
+}
+mem_buffer;
+
+/* Memory region being read. Can be used as io parameter of arcd_dec with
+ * mem_input() callback.
+ */
+typedef struct mem_reader
+{
+	const arcd_buf_t *data;
+	size_t size;
+	size_t pos;
+}
+mem_reader;
+
+void mem_buffer_init(mem_buffer *const b);
+void mem_buffer_free(mem_buffer *const b);
+/* Makes sure that at least size more bytes can be appended without
+ * reallocation. Returns pointer to the end of the buffer data or NULL if
+ * memory can't be allocated (buffer is left unchanged then).
+ */
+arcd_buf_t *mem_buffer_reserve(mem_buffer *const b, const size_t size);
+void mem_buffer_append(mem_buffer *const b, const void *const data,
+					   const size_t size);
+void mem_output(const arcd_buf_t buf, const unsigned buf_bits, void *const io);
+
+void mem_reader_init(mem_reader *const r, const void *const data,
+					 const size_t size);
+unsigned mem_input(arcd_buf_t *const buf, void *const io);
+
+/* Little endian 32-bit integers, used for framing. */
+void mem_put_u32(arcd_buf_t *const p, const unsigned long v);
+unsigned long mem_get_u32(const arcd_buf_t *const p);
+
+#ifdef __cplusplus
+}
+#endif
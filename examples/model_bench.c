@@ -0,0 +1,322 @@
+#define _POSIX_C_SOURCE 200112L
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include <time.h>
+#include <unistd.h>
+#include <arcd.h>
+#include <adaptive_model.h>
+#include <shared_model.h>
+#include <mem_io.h>
+#include <thread_pool.h>
+
+/* Measures how encoding throughput scales with number of threads when every
+ * thread has its own adaptive model (private), when all threads share one
+ * read-only model (shared) and when they share one model with per-thread
+ * adaptive overlay (overlay). Each thread encodes the whole input rounds
+ * times into its own buffer. Also prints how much model state every stream
+ * has to keep on its own in each mode.
+ */
+enum
+{
+	MODE_PRIVATE,
+	MODE_SHARED,
+	MODE_OVERLAY,
+	MODE_COUNT,
+};
+
+static const char *const c_mode_names[MODE_COUNT] =
+{
+	"private", "shared", "overlay",
+};
+
+enum { SYMBOLS = 256 };
+enum { SYNTHETIC_SIZE = 1 << 20 };
+enum { THREADS_MAX = 256 };
+
+typedef struct bench_job
+{
+	unsigned mode;
+	const shared_model *shared;
+	const unsigned char *data;
+	size_t size;
+	unsigned rounds;
+	mem_buffer encoded;
+}
+bench_job;
+
+static void usage(FILE *const out)
+{
+	fprintf(out, "Usage:\n");
+	fprintf(out, "    model_bench [-j THREADS] [-r ROUNDS] [FILE]\n\n");
+	fprintf(out, "-j - maximum number of threads (default: number of CPUs)\n");
+	fprintf(out, "-r - number of times each thread encodes input\n");
+	fprintf(out, "FILE - input data (default: %i synthetic bytes)\n\n",
+			SYNTHETIC_SIZE);
+	fflush(out);
+}
+
+static double now(void)
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+/* Skewed text-like bytes: short words from a small alphabet. */
+static unsigned char *synthetic(const size_t size)
+{
+	unsigned char *const data = (unsigned char *)malloc(size);
+	unsigned long x = 2463534242ul;
+	for (size_t i = 0; size > i; ++i)
+	{
+		x ^= x << 13 & 0xfffffffful;
+		x ^= x >> 17;
+		x ^= x << 5 & 0xfffffffful;
+		const unsigned r = x % 64;
+		data[i] = 8 > r? ' ': 'a' + r % 7 * r % 26;
+	}
+	return data;
+}
+
+static unsigned char *read_file(const char *const path, size_t *const size)
+{
+	FILE *const f = fopen(path, "rb");
+	if (0 == f)
+	{
+		return 0;
+	}
+	unsigned char *data = 0;
+	size_t capacity = 0;
+	*size = 0;
+	for (;;)
+	{
+		if (*size == capacity)
+		{
+			capacity = 0 < capacity? 2 * capacity: 1 << 16;
+			data = (unsigned char *)realloc(data, capacity);
+		}
+		const size_t n = fread(data + *size, 1, capacity - *size, f);
+		if (0 == n)
+		{
+			break;
+		}
+		*size += n;
+	}
+	fclose(f);
+	return data;
+}
+
+/* Everything the encoding loop touches lives on the worker's stack, so
+ * threads don't write to memory near each other's jobs while encoding. Job is
+ * only read at start and written back when done.
+ */
+static void bench_worker(void *const ctx, const unsigned i)
+{
+	bench_job *const job = (bench_job *)ctx + i;
+	const unsigned mode = job->mode;
+	const unsigned rounds = job->rounds;
+	const shared_model *const shared = job->shared;
+	const unsigned char *const data = job->data;
+	const size_t size = job->size;
+	mem_buffer encoded = job->encoded;
+	for (unsigned r = 0; rounds > r; ++r)
+	{
+		adaptive_model private_model;
+		shared_overlay overlay;
+		arcd_enc e;
+		encoded.size = 0;
+		if (MODE_PRIVATE == mode)
+		{
+			adaptive_model_create(&private_model, SYMBOLS);
+			arcd_enc_init(&e, adaptive_model_getprob, &private_model,
+						  mem_output, &encoded);
+		}
+		else if (MODE_SHARED == mode)
+		{
+			arcd_enc_init(&e, shared_model_getprob, (void *)shared,
+						  mem_output, &encoded);
+		}
+		else
+		{
+			shared_overlay_create(&overlay, shared);
+			arcd_enc_init(&e, shared_overlay_getprob, &overlay,
+						  mem_output, &encoded);
+		}
+		for (size_t k = 0; size > k; ++k)
+		{
+			arcd_enc_put(&e, data[k]);
+		}
+		arcd_enc_fin(&e);
+		if (MODE_PRIVATE == mode)
+		{
+			adaptive_model_free(&private_model);
+		}
+		else if (MODE_OVERLAY == mode)
+		{
+			shared_overlay_free(&overlay);
+		}
+	}
+	job->encoded = encoded;
+}
+
+/* Decodes job output and compares it with input. */
+static int verify(const bench_job *const job)
+{
+	adaptive_model private_model;
+	shared_overlay overlay;
+	mem_reader reader;
+	arcd_dec d;
+	mem_reader_init(&reader, job->encoded.data, job->encoded.size);
+	if (MODE_PRIVATE == job->mode)
+	{
+		adaptive_model_create(&private_model, SYMBOLS);
+		arcd_dec_init(&d, adaptive_model_getch, &private_model,
+					  mem_input, &reader);
+	}
+	else if (MODE_SHARED == job->mode)
+	{
+		arcd_dec_init(&d, shared_model_getch, (void *)job->shared,
+					  mem_input, &reader);
+	}
+	else
+	{
+		shared_overlay_create(&overlay, job->shared);
+		arcd_dec_init(&d, shared_overlay_getch, &overlay, mem_input, &reader);
+	}
+	int ok = 1;
+	for (size_t i = 0; ok && job->size > i; ++i)
+	{
+		ok = job->data[i] == arcd_dec_get(&d);
+	}
+	if (MODE_PRIVATE == job->mode)
+	{
+		adaptive_model_free(&private_model);
+	}
+	else if (MODE_OVERLAY == job->mode)
+	{
+		shared_overlay_free(&overlay);
+	}
+	return ok;
+}
+
+/* Runs threads jobs concurrently, returns wall time in seconds. */
+static double run(bench_job *const jobs, const unsigned threads)
+{
+	const double start = now();
+	thread_pool_run(threads, threads, bench_worker, jobs);
+	return now() - start;
+}
+
+int main(int argc, char *argv[])
+{
+	long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+	unsigned max_threads = 0 < cpus? (unsigned)cpus: 1;
+	unsigned rounds = 4;
+	int opt;
+	while (-1 != (opt = getopt(argc, argv, "j:r:h")))
+	{
+		switch (opt)
+		{
+		case 'j':
+			max_threads = (unsigned)atoi(optarg);
+			break;
+		case 'r':
+			rounds = (unsigned)atoi(optarg);
+			break;
+		case 'h':
+			usage(stdout);
+			return 0;
+		default:
+			usage(stderr);
+			return 1;
+		}
+	}
+	if (0 == max_threads || THREADS_MAX < max_threads || 0 == rounds ||
+		optind + 1 < argc)
+	{
+		usage(stderr);
+		return 1;
+	}
+	size_t size = SYNTHETIC_SIZE;
+	unsigned char *const data = optind < argc?
+			read_file(argv[optind], &size): synthetic(size);
+	if (0 == data)
+	{
+		fprintf(stderr, "Can't read \"%s\"\n", argv[optind]);
+		return 1;
+	}
+	unsigned long hist[SYMBOLS] = {0};
+	for (size_t i = 0; size > i; ++i)
+	{
+		++hist[data[i]];
+	}
+	shared_model shared;
+	shared_model_create(&shared, hist, SYMBOLS);
+	bench_job jobs[max_threads];
+	for (unsigned i = 0; max_threads > i; ++i)
+	{
+		jobs[i].shared = &shared;
+		jobs[i].data = data;
+		jobs[i].size = size;
+		jobs[i].rounds = rounds;
+		mem_buffer_init(&jobs[i].encoded);
+	}
+	printf("Input: %zu bytes, %u rounds per thread, %u CPUs\n\n",
+		   size, rounds, 0 < cpus? (unsigned)cpus: 1);
+	printf("%8s", "threads");
+	for (unsigned mode = 0; MODE_COUNT > mode; ++mode)
+	{
+		printf(" %10s MB/s %7s", c_mode_names[mode], "scale");
+	}
+	printf("\n");
+	double base[MODE_COUNT];
+	size_t encoded_size[MODE_COUNT];
+	int result = 0;
+	for (unsigned threads = 1;;
+		 threads = max_threads < 2 * threads? max_threads: 2 * threads)
+	{
+		printf("%8u", threads);
+		for (unsigned mode = 0; MODE_COUNT > mode; ++mode)
+		{
+			for (unsigned i = 0; threads > i; ++i)
+			{
+				jobs[i].mode = mode;
+			}
+			const double seconds = run(jobs, threads);
+			const double speed = (double)size * rounds * threads / seconds / 1e6;
+			if (1 == threads)
+			{
+				base[mode] = speed;
+				encoded_size[mode] = jobs[0].encoded.size;
+			}
+			printf(" %15.2f %6.2fx", speed, speed / base[mode]);
+			fflush(stdout);
+			if (!verify(&jobs[threads - 1]))
+			{
+				fprintf(stderr, "\nDecoded %s output doesn't match input\n",
+						c_mode_names[mode]);
+				result = 1;
+			}
+		}
+		printf("\n");
+		if (max_threads == threads)
+		{
+			break;
+		}
+	}
+	printf("\nEncoded size: private %zu, shared %zu, overlay %zu bytes\n",
+		   encoded_size[MODE_PRIVATE], encoded_size[MODE_SHARED],
+		   encoded_size[MODE_OVERLAY]);
+	printf("Per-stream model state: private %zu, shared %zu, overlay %zu bytes\n",
+		   sizeof(adaptive_model) + sizeof(unsigned short) * SYMBOLS,
+		   sizeof(void *), sizeof(shared_overlay));
+	for (unsigned i = 0; max_threads > i; ++i)
+	{
+		mem_buffer_free(&jobs[i].encoded);
+	}
+	shared_model_free(&shared);
+	free(data);
+	return result;
+}
@@ -0,0 +1,268 @@
+#include <assert.h>
+#include <stdlib.h>
+#include "numeric_coder.h"
+
+enum
+{
+	MODE_BUCKET,
+	MODE_BIT,
+	MODE_RAW,
+};
+
+/* Binary models keep probability of 0 with BIT_PROB_BITS precision and move
+ * it by 1/2^BIT_ADAPT_SHIFT of the distance to the observed bit.
+ */
+enum { BIT_PROB_BITS = 12 };
+enum { BIT_ADAPT_SHIFT = 4 };
+enum { RAW_CHUNK_BITS = 12 };
+
+static uint64_t zigzag(const uint64_t u)
+{
+	return u << 1 ^ (0 - (u >> 63));
+}
+
+static uint64_t unzigzag(const uint64_t z)
+{
+	return z >> 1 ^ (0 - (z & 1));
+}
+
+/* Transforms are done in unsigned arithmetic, so overflow wraps around and
+ * inverse transform restores the original value exactly.
+ */
+static uint64_t transform(numeric_model *const m, const uint64_t v)
+{
+	const uint64_t delta = v - m->prev;
+	m->prev = v;
+	if (NUMERIC_DELTA == m->transform)
+	{
+		return delta;
+	}
+	if (NUMERIC_DELTA2 == m->transform)
+	{
+		const uint64_t delta2 = delta - m->prev_delta;
+		m->prev_delta = delta;
+		return delta2;
+	}
+	return v;
+}
+
+static uint64_t untransform(numeric_model *const m, const uint64_t u)
+{
+	uint64_t delta = u;
+	if (NUMERIC_RAW == m->transform)
+	{
+		m->prev = u;
+		return u;
+	}
+	if (NUMERIC_DELTA2 == m->transform)
+	{
+		delta = m->prev_delta + u;
+		m->prev_delta = delta;
+	}
+	m->prev += delta;
+	return m->prev;
+}
+
+static void bit_update(unsigned short *const p, const unsigned bit)
+{
+	if (0 == bit)
+	{
+		*p += ((1u << BIT_PROB_BITS) - *p) >> BIT_ADAPT_SHIFT;
+	}
+	else
+	{
+		*p -= *p >> BIT_ADAPT_SHIFT;
+	}
+}
+
+void numeric_model_init(numeric_model *const m, const unsigned transform)
+{
+	assert(NUMERIC_RAW == transform || NUMERIC_DELTA == transform ||
+		   NUMERIC_DELTA2 == transform);
+	m->transform = transform;
+	m->prev = 0;
+	m->prev_delta = 0;
+	m->bucket = 0;
+	m->mode = MODE_BUCKET;
+	m->bits = 0;
+	m->bit = 0;
+	for (unsigned i = 0; NUMERIC_BUCKETS > i; ++i)
+	{
+		freq_table_init(&m->bucket_table[i], m->bucket_freq[i],
+						NUMERIC_BUCKETS);
+		for (unsigned k = 0; (1 << NUMERIC_MANTISSA_MODEL_BITS) > k; ++k)
+		{
+			m->mantissa[i][k] = 1 << (BIT_PROB_BITS - 1);
+		}
+	}
+}
+
+void numeric_model_getprob(const arcd_char_t ch, arcd_prob *const prob,
+						   void *const model)
+{
+	numeric_model *const m = (numeric_model *)model;
+	if (MODE_RAW == m->mode)
+	{
+		raw_bits_getprob(m->bits, ch, prob);
+		return;
+	}
+	if (MODE_BIT == m->mode)
+	{
+		const unsigned p = *m->bit;
+		prob->lower = 0 == ch? 0: p;
+		prob->upper = 0 == ch? p: 1u << BIT_PROB_BITS;
+		prob->total = 1u << BIT_PROB_BITS;
+		bit_update(m->bit, ch);
+		return;
+	}
+	freq_table_getprob(&m->bucket_table[m->bucket], ch, prob);
+}
+
+arcd_char_t numeric_model_getch(const arcd_range_t v, const arcd_range_t range,
+								arcd_prob *const prob, void *const model)
+{
+	numeric_model *const m = (numeric_model *)model;
+	if (MODE_RAW == m->mode)
+	{
+		return raw_bits_getch(m->bits, v, range, prob);
+	}
+	if (MODE_BIT == m->mode)
+	{
+		const arcd_freq_t total = 1u << BIT_PROB_BITS;
+		const unsigned p = *m->bit;
+		const unsigned bit = p <= arcd_freq_scale(v, range, total);
+		prob->lower = 0 == bit? 0: p;
+		prob->upper = 0 == bit? p: total;
+		prob->total = total;
+		bit_update(m->bit, bit);
+		return bit;
+	}
+	return freq_table_getch(&m->bucket_table[m->bucket], v, range, prob);
+}
+
+void numeric_model_put(arcd_enc *const e, numeric_model *const m,
+					   const int64_t v)
+{
+	const uint64_t z = zigzag(transform(m, (uint64_t)v));
+	const unsigned bucket = bit_length(z);
+	m->mode = MODE_BUCKET;
+	arcd_enc_put(e, bucket);
+	m->bucket = bucket;
+	unsigned left = 1 < bucket? bucket - 1: 0;
+	m->mode = MODE_BIT;
+	for (unsigned node = 1, k = 0; NUMERIC_MANTISSA_MODEL_BITS > k &&
+		 0 < left; ++k)
+	{
+		const unsigned bit = 1 & (z >> --left);
+		m->bit = &m->mantissa[bucket][node];
+		arcd_enc_put(e, bit);
+		node = 2 * node + bit;
+	}
+	m->mode = MODE_RAW;
+	while (0 < left)
+	{
+		m->bits = RAW_CHUNK_BITS < left? RAW_CHUNK_BITS: left;
+		left -= m->bits;
+		arcd_enc_put(e, (arcd_char_t)(z >> left) & ((1u << m->bits) - 1));
+	}
+	m->mode = MODE_BUCKET;
+}
+
+int64_t numeric_model_get(arcd_dec *const d, numeric_model *const m)
+{
+	m->mode = MODE_BUCKET;
+	const unsigned bucket = arcd_dec_get(d);
+	m->bucket = bucket;
+	uint64_t z = 0 < bucket? 1: 0;
+	unsigned left = 1 < bucket? bucket - 1: 0;
+	m->mode = MODE_BIT;
+	for (unsigned node = 1, k = 0; NUMERIC_MANTISSA_MODEL_BITS > k &&
+		 0 < left; ++k, --left)
+	{
+		m->bit = &m->mantissa[bucket][node];
+		const unsigned bit = arcd_dec_get(d);
+		z = z << 1 | bit;
+		node = 2 * node + bit;
+	}
+	m->mode = MODE_RAW;
+	while (0 < left)
+	{
+		m->bits = RAW_CHUNK_BITS < left? RAW_CHUNK_BITS: left;
+		left -= m->bits;
+		z = z << m->bits | arcd_dec_get(d);
+	}
+	m->mode = MODE_BUCKET;
+	return (int64_t)untransform(m, unzigzag(z));
+}
+
+void numeric_encode(const int64_t *const values, const size_t count,
+					const unsigned transform, mem_buffer *const out)
+{
+	assert(UINT32_MAX >= count);
+	const size_t header = out->size;
+	mem_buffer_reserve(out, NUMERIC_HEADER_SIZE);
+	out->size += NUMERIC_HEADER_SIZE;
+	numeric_model *const m = (numeric_model *)malloc(sizeof(*m));
+	numeric_model_init(m, transform);
+	arcd_enc e;
+	arcd_enc_init(&e, numeric_model_getprob, m, mem_output, out);
+	for (size_t i = 0; count > i; ++i)
+	{
+		numeric_model_put(&e, m, values[i]);
+	}
+	arcd_enc_fin(&e);
+	free(m);
+	arcd_buf_t *const p = out->data + header;
+	mem_put_u32(p, count);
+	mem_put_u32(p + 4, out->size - header - NUMERIC_HEADER_SIZE);
+	mem_put_u32(p + 8, transform);
+}
+
+size_t numeric_decoded_count(const unsigned char *const header)
+{
+	return mem_get_u32(header);
+}
+
+size_t numeric_payload_size(const unsigned char *const header)
+{
+	return mem_get_u32(header + 4);
+}
+
+int numeric_check(const unsigned char *const in, const size_t in_size)
+{
+	if (NUMERIC_HEADER_SIZE > in_size)
+	{
+		return -1;
+	}
+	const size_t count = numeric_decoded_count(in);
+	const size_t payload_size = numeric_payload_size(in);
+	if (in_size - NUMERIC_HEADER_SIZE < payload_size ||
+		NUMERIC_DELTA2 < mem_get_u32(in + 8))
+	{
+		return -1;
+	}
+	return payload_size < count / NUMERIC_RATIO_MAX? -1: 0;
+}
+
+int numeric_decode(const unsigned char *const in, const size_t in_size,
+				   int64_t *const out)
+{
+	if (0 != numeric_check(in, in_size))
+	{
+		return -1;
+	}
+	const size_t count = numeric_decoded_count(in);
+	numeric_model *const m = (numeric_model *)malloc(sizeof(*m));
+	numeric_model_init(m, mem_get_u32(in + 8));
+	mem_reader reader;
+	mem_reader_init(&reader, in + NUMERIC_HEADER_SIZE,
+					numeric_payload_size(in));
+	arcd_dec d;
+	arcd_dec_init(&d, numeric_model_getch, m, mem_input, &reader);
+	for (size_t i = 0; count > i; ++i)
+	{
+		out[i] = numeric_model_get(&d, m);
+	}
+	free(m);
+	return 0;
+}
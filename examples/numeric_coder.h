@@ -0,0 +1,95 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <arcd.h>
+#include "freq_table.h"
+#include "mem_io.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Coder for columns of integers (timestamps, counters, gauges). Each value is
+ * optionally replaced with its delta or delta-of-delta from previous values,
+ * mapped to unsigned with zigzag encoding and coded Elias-gamma style: bit
+ * length (bucket) goes through adaptive model conditioned on previous bucket,
+ * few top mantissa bits go through adaptive binary models and remaining
+ * mantissa bits are coded as is.
+ *
+ * Single values are coded with numeric_model_put() and numeric_model_get(),
+ * since one value takes several coder symbols. Encoder (decoder) must be
+ * initialized with numeric_model_getprob() (numeric_model_getch()) and the
+ * same model. Bulk functions code the whole column into a framed buffer.
+ */
+enum
+{
+	NUMERIC_RAW,
+	NUMERIC_DELTA,
+	NUMERIC_DELTA2,
+};
+
+enum { NUMERIC_BUCKETS = 65 };
+enum { NUMERIC_MANTISSA_MODEL_BITS = 3 };
+
+typedef struct numeric_model
+{
+	unsigned transform;
+	uint64_t prev;
+	uint64_t prev_delta;
+	unsigned bucket;
+	unsigned mode;
+	unsigned bits;
+	unsigned short *bit;
+	freq_table bucket_table[NUMERIC_BUCKETS];
+	unsigned short bucket_freq[NUMERIC_BUCKETS][NUMERIC_BUCKETS];
+	unsigned short mantissa[NUMERIC_BUCKETS][1 << NUMERIC_MANTISSA_MODEL_BITS];
+}
+numeric_model;
+
+void numeric_model_init(numeric_model *const m, const unsigned transform);
+void numeric_model_getprob(const arcd_char_t ch, arcd_prob *const prob,
+						   void *const model);
+arcd_char_t numeric_model_getch(const arcd_range_t v, const arcd_range_t range,
+								arcd_prob *const prob, void *const model);
+/* Encodes one value. Will call arcd_enc_put() one or more times. */
+void numeric_model_put(arcd_enc *const e, numeric_model *const m,
+					   const int64_t v);
+/* Decodes one value. Will call arcd_dec_get() one or more times. */
+int64_t numeric_model_get(arcd_dec *const d, numeric_model *const m);
+
+/* Encoded column starts with NUMERIC_HEADER_SIZE bytes header that holds value
+ * count, payload size and transform (all 32-bit little endian), followed by
+ * the arithmetic coder payload.
+ */
+enum { NUMERIC_HEADER_SIZE = 12 };
+/* Upper bound of values per payload byte. Every value takes at least a bucket
+ * symbol and the most probable bucket can't have probability above
+ * (ARCD_FREQ_MAX - 64) / ARCD_FREQ_MAX, so value takes more than 2.8e-3 bits
+ * (about 2840 values per payload byte). Frames above it are rejected.
+ */
+enum { NUMERIC_RATIO_MAX = 1 << 12 };
+
+/* Encodes count values and appends result to out. */
+void numeric_encode(const int64_t *const values, const size_t count,
+					const unsigned transform, mem_buffer *const out);
+/* Returns number of values in the column with specified header. */
+size_t numeric_decoded_count(const unsigned char *const header);
+/* Returns payload size of the column with specified header. */
+size_t numeric_payload_size(const unsigned char *const header);
+/* Checks that in_size bytes from in hold the whole header and payload, that
+ * transform is known and that value count is plausible for the payload size,
+ * so it is safe to allocate numeric_decoded_count() values. Returns 0 if so
+ * and non-zero otherwise.
+ */
+int numeric_check(const unsigned char *const in, const size_t in_size);
+/* Decodes in_size bytes from in (including header) into out, which must have
+ * room for numeric_decoded_count() values. Returns 0 on success and non-zero
+ * if data is malformed.
+ */
+int numeric_decode(const unsigned char *const in, const size_t in_size,
+				   int64_t *const out);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,214 @@
+#include <assert.h>
+#include <stdlib.h>
+#include "shared_model.h"
+
+/* Boosts are kept below half of the shared total, so few stream symbols
+ * don't take probability away from the rest of the alphabet.
+ */
+enum { OVERLAY_INC = 32 };
+enum { OVERLAY_TOTAL_MAX = SHARED_MODEL_TOTAL / 2 };
+
+void shared_model_create(shared_model *const m, const unsigned long *const hist,
+						 const unsigned size)
+{
+	assert(0 < size && SHARED_MODEL_TOTAL >= size);
+	unsigned long long sum = 0;
+	unsigned top = 0;
+	for (unsigned i = 0; size > i; ++i)
+	{
+		sum += hist[i];
+		top = hist[top] < hist[i]? i: top;
+	}
+	m->size = size;
+	m->freq = (unsigned short *)malloc(sizeof(m->freq[0]) * (size + 1));
+	m->lookup = (unsigned short *)malloc(
+			sizeof(m->lookup[0]) * SHARED_MODEL_TOTAL);
+	/* Each symbol gets 1 and its share of the rest, rounding error goes to the
+	 * most frequent symbol.
+	 */
+	const unsigned spare = SHARED_MODEL_TOTAL - size;
+	m->freq[0] = 0;
+	for (unsigned i = 0; size > i; ++i)
+	{
+		const unsigned freq =
+				1 + (0 != sum? hist[i] * (unsigned long long)spare / sum: 0);
+		m->freq[i + 1] = m->freq[i] + freq;
+	}
+	const unsigned rest = SHARED_MODEL_TOTAL - m->freq[size];
+	for (unsigned i = top + 1; size >= i; ++i)
+	{
+		m->freq[i] += rest;
+	}
+	for (unsigned i = 0; size > i; ++i)
+	{
+		for (unsigned k = m->freq[i]; m->freq[i + 1] > k; ++k)
+		{
+			m->lookup[k] = i;
+		}
+	}
+}
+
+void shared_model_free(shared_model *const m)
+{
+	free(m->lookup);
+	free(m->freq);
+}
+
+void shared_model_getprob(const arcd_char_t ch, arcd_prob *const prob,
+						  void *const model)
+{
+	const shared_model *const m = (const shared_model *)model;
+	assert(m->size > ch);
+	prob->lower = m->freq[ch];
+	prob->upper = m->freq[ch + 1];
+	prob->total = SHARED_MODEL_TOTAL;
+}
+
+arcd_char_t shared_model_getch(const arcd_range_t v, const arcd_range_t range,
+							   arcd_prob *const prob, void *const model)
+{
+	const shared_model *const m = (const shared_model *)model;
+	const arcd_char_t ch =
+			m->lookup[arcd_freq_scale(v, range, SHARED_MODEL_TOTAL)];
+	prob->lower = m->freq[ch];
+	prob->upper = m->freq[ch + 1];
+	prob->total = SHARED_MODEL_TOTAL;
+	return ch;
+}
+
+/* Halves all boosts and drops slots that reach 0. */
+static void overlay_rescale(shared_overlay *const o)
+{
+	unsigned n = 0;
+	o->total = 0;
+	for (unsigned i = 0; o->count > i; ++i)
+	{
+		const unsigned boost = o->boost[i] / 2;
+		if (0 != boost)
+		{
+			o->ch[n] = o->ch[i];
+			o->boost[n] = boost;
+			o->total += boost;
+			++n;
+		}
+	}
+	o->count = n;
+}
+
+static void overlay_update(shared_overlay *const o, const arcd_char_t ch)
+{
+	unsigned i = 0;
+	while (o->count > i && ch > o->ch[i])
+	{
+		++i;
+	}
+	if (o->count == i || ch != o->ch[i])
+	{
+		if (SHARED_OVERLAY_SLOTS == o->count)
+		{
+			unsigned victim = 0;
+			for (unsigned k = 1; o->count > k; ++k)
+			{
+				victim = o->boost[victim] > o->boost[k]? k: victim;
+			}
+			o->total -= o->boost[victim];
+			for (unsigned k = victim + 1; o->count > k; ++k)
+			{
+				o->ch[k - 1] = o->ch[k];
+				o->boost[k - 1] = o->boost[k];
+			}
+			--o->count;
+			i -= victim < i;
+		}
+		for (unsigned k = o->count; i < k; --k)
+		{
+			o->ch[k] = o->ch[k - 1];
+			o->boost[k] = o->boost[k - 1];
+		}
+		o->ch[i] = ch;
+		o->boost[i] = 0;
+		++o->count;
+	}
+	o->boost[i] += OVERLAY_INC;
+	o->total += OVERLAY_INC;
+	if (OVERLAY_TOTAL_MAX < o->total)
+	{
+		overlay_rescale(o);
+	}
+}
+
+void shared_overlay_create(shared_overlay *const o,
+						   const shared_model *const shared)
+{
+	o->shared = shared;
+	o->count = 0;
+	o->total = 0;
+}
+
+void shared_overlay_free(shared_overlay *const o)
+{
+	(void)o;
+}
+
+void shared_overlay_getprob(const arcd_char_t ch, arcd_prob *const prob,
+							void *const model)
+{
+	shared_overlay *const o = (shared_overlay *)model;
+	const unsigned short *const freq = o->shared->freq;
+	assert(o->shared->size > ch);
+	/* Boost of a symbol follows its shared frequency. */
+	unsigned before = 0;
+	unsigned boost = 0;
+	for (unsigned i = 0; o->count > i && ch >= o->ch[i]; ++i)
+	{
+		if (ch == o->ch[i])
+		{
+			boost = o->boost[i];
+			break;
+		}
+		before += o->boost[i];
+	}
+	prob->lower = freq[ch] + before;
+	prob->upper = freq[ch + 1] + before + boost;
+	prob->total = SHARED_MODEL_TOTAL + o->total;
+	overlay_update(o, ch);
+}
+
+arcd_char_t shared_overlay_getch(const arcd_range_t v, const arcd_range_t range,
+								 arcd_prob *const prob, void *const model)
+{
+	shared_overlay *const o = (shared_overlay *)model;
+	const shared_model *const shared = o->shared;
+	const arcd_freq_t total = SHARED_MODEL_TOTAL + o->total;
+	const arcd_freq_t scaled = arcd_freq_scale(v, range, total);
+	/* Between boosted symbols the combined distribution is the shared one
+	 * shifted by boosts of preceding slots, so shared lookup table works
+	 * there.
+	 */
+	unsigned before = 0;
+	arcd_char_t ch = 0;
+	unsigned boost = 0;
+	for (unsigned i = 0; o->count > i; ++i)
+	{
+		ch = o->ch[i];
+		if (shared->freq[ch] + before > scaled)
+		{
+			break;
+		}
+		if (shared->freq[ch + 1] + before + o->boost[i] > scaled)
+		{
+			boost = o->boost[i];
+			break;
+		}
+		before += o->boost[i];
+	}
+	if (0 == boost)
+	{
+		ch = shared->lookup[scaled - before];
+	}
+	prob->lower = shared->freq[ch] + before;
+	prob->upper = shared->freq[ch + 1] + before + boost;
+	prob->total = total;
+	overlay_update(o, ch);
+	return ch;
+}
@@ -0,0 +1,68 @@
+#pragma once
+
+#include <arcd.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Static model that can be shared by any number of encoders and decoders
+ * running in different threads. It is built once from a histogram and never
+ * modified after that, so callbacks only read it and need no locks. Since
+ * callbacks take non-const model pointer, pass (void *)&shared_model to
+ * arcd_enc_init() and arcd_dec_init().
+ *
+ * Frequencies are normalized to SHARED_MODEL_TOTAL, every symbol gets at
+ * least 1. Decoder uses lookup table with symbol for every frequency value.
+ */
+enum { SHARED_MODEL_TOTAL = 1 << 12 };
+
+typedef struct shared_model
+{
+	unsigned size;
+	unsigned short *freq;
+	unsigned short *lookup;
+}
+shared_model;
+
+/* Creates model for size symbols with counts from hist. */
+void shared_model_create(shared_model *const m, const unsigned long *const hist,
+						 const unsigned size);
+void shared_model_free(shared_model *const m);
+void shared_model_getprob(const arcd_char_t ch, arcd_prob *const prob,
+						  void *const model);
+arcd_char_t shared_model_getch(const arcd_range_t v, const arcd_range_t range,
+							   arcd_prob *const prob, void *const model);
+
+/* Per-stream adaptive overlay on top of shared model. It keeps a few symbols
+ * that are frequent in the stream (at most SHARED_OVERLAY_SLOTS, sorted by
+ * symbol) with boosts that are added to their shared frequencies. Overlay
+ * has fixed size (two cache lines on 64-bit targets) regardless of alphabet
+ * size and coding a symbol costs a scan over SHARED_OVERLAY_SLOTS slots on top
+ * of shared model lookup. When all slots are taken, new symbol replaces the
+ * one with the smallest boost. Each stream (encoder or decoder) needs its own
+ * overlay, shared model is only read.
+ */
+enum { SHARED_OVERLAY_SLOTS = 16 };
+
+typedef struct shared_overlay
+{
+	const shared_model *shared;
+	unsigned count;
+	unsigned total;
+	unsigned short ch[SHARED_OVERLAY_SLOTS];
+	unsigned short boost[SHARED_OVERLAY_SLOTS];
+}
+shared_overlay;
+
+void shared_overlay_create(shared_overlay *const o,
+						   const shared_model *const shared);
+void shared_overlay_free(shared_overlay *const o);
+void shared_overlay_getprob(const arcd_char_t ch, arcd_prob *const prob,
+							void *const model);
+arcd_char_t shared_overlay_getch(const arcd_range_t v, const arcd_range_t range,
+								 arcd_prob *const prob, void *const model);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,412 @@
+#include <assert.h>
+#include <stdlib.h>
+#include "sparse_model.h"
+
+/* Model modes. Value coded by sparse_model_put() is either a symbol known to
+ * the model or an escape followed by bit length and mantissa bits of the value.
+ */
+enum
+{
+	MODE_SYMBOL,
+	MODE_LENGTH,
+	MODE_BITS,
+};
+
+enum { LENGTH_COUNT = 8 * sizeof(arcd_char_t) + 1 };
+enum { MANTISSA_CHUNK_BITS = 8 };
+enum { ALLOCATED_MIN = 16 };
+
+static unsigned hash(const arcd_char_t ch, const unsigned mask)
+{
+	unsigned h = ch * 2654435761u;
+	h ^= h >> 16;
+	return h & mask;
+}
+
+static unsigned find(const sparse_model *const m, const arcd_char_t ch)
+{
+	if (0 == m->allocated)
+	{
+		return m->count;
+	}
+	for (unsigned s = hash(ch, m->slots_mask);; s = (s + 1) & m->slots_mask)
+	{
+		const unsigned i = m->slots[s];
+		if (0 == i)
+		{
+			return m->count;
+		}
+		if (ch == m->entries[i - 1].ch)
+		{
+			return i - 1;
+		}
+	}
+}
+
+static void slot_insert(sparse_model *const m, const unsigned i)
+{
+	unsigned s = hash(m->entries[i].ch, m->slots_mask);
+	while (0 != m->slots[s])
+	{
+		s = (s + 1) & m->slots_mask;
+	}
+	m->slots[s] = i + 1;
+	m->entries[i].slot = s;
+}
+
+/* Removes slot s from the hash table. Uses backward shift deletion, so lookups
+ * never have to skip over tombstones.
+ */
+static void slot_remove(sparse_model *const m, unsigned s)
+{
+	const unsigned mask = m->slots_mask;
+	for (unsigned n = (s + 1) & mask; 0 != m->slots[n]; n = (n + 1) & mask)
+	{
+		sparse_model_entry *const e = &m->entries[m->slots[n] - 1];
+		const unsigned home = hash(e->ch, mask);
+		if (((n - home) & mask) >= ((n - s) & mask))
+		{
+			m->slots[s] = m->slots[n];
+			e->slot = s;
+			s = n;
+		}
+	}
+	m->slots[s] = 0;
+}
+
+/* Marks ends of the recency list. */
+static const unsigned NONE = (unsigned)-1;
+
+/* Adds delta (possibly wrapped negative) to frequency of entry i. */
+static void tree_add(sparse_model *const m, const unsigned i,
+					 const unsigned delta)
+{
+	for (unsigned k = i + 1; m->allocated >= k; k += k & (0u - k))
+	{
+		m->tree[k] += delta;
+	}
+}
+
+/* Returns sum of frequencies of entries before entry i. */
+static unsigned tree_sum(const sparse_model *const m, const unsigned i)
+{
+	unsigned sum = 0;
+	for (unsigned k = i; 0 < k; k -= k & (0u - k))
+	{
+		sum += m->tree[k];
+	}
+	return sum;
+}
+
+/* Returns entry with cumulative interval that contains v. Lower bound of that
+ * interval is stored to lower.
+ */
+static unsigned tree_find(const sparse_model *const m, unsigned v,
+						  unsigned *const lower)
+{
+	unsigned step = 1;
+	while (m->allocated >= 2 * step)
+	{
+		step *= 2;
+	}
+	unsigned i = 0;
+	*lower = 0;
+	for (; 0 < step; step /= 2)
+	{
+		if (m->allocated >= i + step && m->tree[i + step] <= v)
+		{
+			i += step;
+			v -= m->tree[i];
+			*lower += m->tree[i];
+		}
+	}
+	return i;
+}
+
+static void tree_build(sparse_model *const m)
+{
+	for (unsigned k = 1; m->allocated >= k; ++k)
+	{
+		m->tree[k] = m->count >= k? m->entries[k - 1].freq: 0;
+	}
+	for (unsigned k = 1; m->allocated >= k; ++k)
+	{
+		const unsigned parent = k + (k & (0u - k));
+		if (m->allocated >= parent)
+		{
+			m->tree[parent] += m->tree[k];
+		}
+	}
+}
+
+static void lru_unlink(sparse_model *const m, const unsigned i)
+{
+	sparse_model_entry *const e = &m->entries[i];
+	if (NONE != e->newer)
+	{
+		m->entries[e->newer].older = e->older;
+	}
+	else
+	{
+		m->newest = e->older;
+	}
+	if (NONE != e->older)
+	{
+		m->entries[e->older].newer = e->newer;
+	}
+	else
+	{
+		m->oldest = e->newer;
+	}
+}
+
+static void lru_push(sparse_model *const m, const unsigned i)
+{
+	sparse_model_entry *const e = &m->entries[i];
+	e->newer = NONE;
+	e->older = m->newest;
+	if (NONE != m->newest)
+	{
+		m->entries[m->newest].newer = i;
+	}
+	else
+	{
+		m->oldest = i;
+	}
+	m->newest = i;
+}
+
+static void grow(sparse_model *const m)
+{
+	unsigned allocated = 2 * m->allocated;
+	if (ALLOCATED_MIN > allocated)
+	{
+		allocated = ALLOCATED_MIN;
+	}
+	if (m->capacity < allocated)
+	{
+		allocated = m->capacity;
+	}
+	unsigned slots_count = 1;
+	while (2 * allocated > slots_count)
+	{
+		slots_count *= 2;
+	}
+	m->entries = (sparse_model_entry *)realloc(m->entries,
+			sizeof(m->entries[0]) * allocated);
+	free(m->tree);
+	m->tree = (unsigned *)malloc(sizeof(m->tree[0]) * (allocated + 1));
+	free(m->slots);
+	m->slots = (unsigned *)calloc(slots_count, sizeof(m->slots[0]));
+	m->slots_mask = slots_count - 1;
+	m->allocated = allocated;
+	for (unsigned i = 0; m->count > i; ++i)
+	{
+		slot_insert(m, i);
+	}
+	tree_build(m);
+}
+
+/* Halves all frequencies. Rounding up never produces zero, so every symbol in
+ * the model can still be coded.
+ */
+static void rescale(sparse_model *const m)
+{
+	if (ARCD_FREQ_MAX >= m->total)
+	{
+		return;
+	}
+	m->escape = (m->escape + 1) / 2;
+	m->total = m->escape;
+	for (unsigned i = 0; m->count > i; ++i)
+	{
+		m->entries[i].freq = (m->entries[i].freq + 1) / 2;
+		m->total += m->entries[i].freq;
+	}
+	tree_build(m);
+}
+
+static void update(sparse_model *const m, const unsigned i)
+{
+	m->entries[i].freq += FREQ_TABLE_INC;
+	tree_add(m, i, FREQ_TABLE_INC);
+	m->total += FREQ_TABLE_INC;
+	lru_unlink(m, i);
+	lru_push(m, i);
+	rescale(m);
+}
+
+static void update_escape(sparse_model *const m)
+{
+	m->escape += FREQ_TABLE_INC;
+	m->total += FREQ_TABLE_INC;
+	rescale(m);
+}
+
+/* When model is full, the least recently used symbol is evicted and its entry
+ * is reused. New symbol becomes the most recently used one, so it survives
+ * the next eviction.
+ */
+static void insert(sparse_model *const m, const arcd_char_t ch)
+{
+	unsigned i;
+	if (m->capacity == m->count)
+	{
+		i = m->oldest;
+		m->total -= m->entries[i].freq;
+		tree_add(m, i, 0u - m->entries[i].freq);
+		slot_remove(m, m->entries[i].slot);
+		lru_unlink(m, i);
+	}
+	else
+	{
+		if (m->allocated == m->count)
+		{
+			grow(m);
+		}
+		i = m->count++;
+	}
+	m->entries[i].ch = ch;
+	m->entries[i].freq = FREQ_TABLE_INC;
+	tree_add(m, i, FREQ_TABLE_INC);
+	slot_insert(m, i);
+	lru_push(m, i);
+	m->total += FREQ_TABLE_INC;
+	rescale(m);
+}
+
+void sparse_model_create(sparse_model *const m, const unsigned capacity)
+{
+	assert(0 < capacity && SPARSE_MODEL_CAPACITY_MAX >= capacity);
+	m->capacity = capacity;
+	m->count = 0;
+	m->allocated = 0;
+	m->escape = 1;
+	m->total = m->escape;
+	m->mode = MODE_SYMBOL;
+	m->bits = 0;
+	m->escaped = 0;
+	m->newest = NONE;
+	m->oldest = NONE;
+	m->slots_mask = 0;
+	m->slots = 0;
+	m->entries = 0;
+	m->tree = 0;
+	freq_table_init(&m->length, m->length_freq, LENGTH_COUNT);
+}
+
+void sparse_model_free(sparse_model *const m)
+{
+	free(m->tree);
+	free(m->slots);
+	free(m->entries);
+}
+
+void sparse_model_getprob(const arcd_char_t ch, arcd_prob *const prob,
+						  void *const model)
+{
+	sparse_model *const m = (sparse_model *)model;
+	if (MODE_BITS == m->mode)
+	{
+		raw_bits_getprob(m->bits, ch, prob);
+		return;
+	}
+	if (MODE_LENGTH == m->mode)
+	{
+		freq_table_getprob(&m->length, ch, prob);
+		return;
+	}
+	const unsigned i = find(m, ch);
+	prob->total = m->total;
+	if (m->count == i)
+	{
+		prob->lower = m->total - m->escape;
+		prob->upper = m->total;
+		m->escaped = 1;
+		update_escape(m);
+		return;
+	}
+	const arcd_freq_t lower = tree_sum(m, i);
+	prob->lower = lower;
+	prob->upper = lower + m->entries[i].freq;
+	m->escaped = 0;
+	update(m, i);
+}
+
+arcd_char_t sparse_model_getch(const arcd_range_t v, const arcd_range_t range,
+							   arcd_prob *const prob, void *const model)
+{
+	sparse_model *const m = (sparse_model *)model;
+	if (MODE_BITS == m->mode)
+	{
+		return raw_bits_getch(m->bits, v, range, prob);
+	}
+	if (MODE_LENGTH == m->mode)
+	{
+		return freq_table_getch(&m->length, v, range, prob);
+	}
+	const arcd_freq_t freq = arcd_freq_scale(v, range, m->total);
+	prob->total = m->total;
+	if (m->total - m->escape <= freq)
+	{
+		prob->lower = m->total - m->escape;
+		prob->upper = m->total;
+		m->escaped = 1;
+		update_escape(m);
+		return 0;
+	}
+	unsigned lower;
+	const unsigned i = tree_find(m, freq, &lower);
+	assert(m->count > i);
+	prob->lower = lower;
+	prob->upper = lower + m->entries[i].freq;
+	m->escaped = 0;
+	update(m, i);
+	return m->entries[i].ch;
+}
+
+void sparse_model_put(arcd_enc *const e, sparse_model *const m,
+					  const arcd_char_t ch)
+{
+	m->mode = MODE_SYMBOL;
+	arcd_enc_put(e, ch);
+	if (!m->escaped)
+	{
+		return;
+	}
+	const unsigned length = bit_length(ch);
+	m->mode = MODE_LENGTH;
+	arcd_enc_put(e, length);
+	m->mode = MODE_BITS;
+	for (unsigned left = 1 < length? length - 1: 0; 0 < left;)
+	{
+		m->bits = MANTISSA_CHUNK_BITS < left? MANTISSA_CHUNK_BITS: left;
+		left -= m->bits;
+		arcd_enc_put(e, (ch >> left) & ((1u << m->bits) - 1));
+	}
+	m->mode = MODE_SYMBOL;
+	insert(m, ch);
+}
+
+arcd_char_t sparse_model_get(arcd_dec *const d, sparse_model *const m)
+{
+	m->mode = MODE_SYMBOL;
+	arcd_char_t ch = arcd_dec_get(d);
+	if (!m->escaped)
+	{
+		return ch;
+	}
+	m->mode = MODE_LENGTH;
+	const unsigned length = arcd_dec_get(d);
+	ch = 0 < length? 1u << (length - 1): 0;
+	m->mode = MODE_BITS;
+	for (unsigned left = 1 < length? length - 1: 0; 0 < left;)
+	{
+		m->bits = MANTISSA_CHUNK_BITS < left? MANTISSA_CHUNK_BITS: left;
+		left -= m->bits;
+		ch |= arcd_dec_get(d) << left;
+	}
+	m->mode = MODE_SYMBOL;
+	insert(m, ch);
+	return ch;
+}
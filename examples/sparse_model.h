@@ -0,0 +1,78 @@
+#pragma once
+
+#include <arcd.h>
+#include "freq_table.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Adaptive model for large sparse alphabets (e.g. 32-bit identifiers or
+ * hashes). Only recently seen symbols are kept in the model. They are located
+ * through an open addressing hash table, their cumulative frequencies are kept
+ * in a Fenwick tree and they are linked into a list ordered by recency of use.
+ * So every operation takes O(log capacity) time. Symbol that is not in the
+ * model is coded as an escape followed by its bit length and raw mantissa
+ * bits. When model holds capacity symbols, inserting a new one evicts the
+ * least recently used symbol, so identifiers that went out of use leave the
+ * model regardless of how frequent they were. Tables grow on demand, so memory
+ * is proportional to the number of distinct active symbols and never exceeds
+ * what capacity requires.
+ *
+ * Since one value can take several coder symbols, model must be used through
+ * sparse_model_put() and sparse_model_get() and not through arcd_enc_put() and
+ * arcd_dec_get() directly. Encoder (decoder) must be initialized with
+ * sparse_model_getprob() (sparse_model_getch()) and the same model.
+ */
+typedef struct sparse_model_entry
+{
+	arcd_char_t ch;
+	unsigned freq;
+	unsigned slot;
+	/* Neighbours in the recency list, more and less recently used. */
+	unsigned newer;
+	unsigned older;
+}
+sparse_model_entry;
+
+typedef struct sparse_model
+{
+	unsigned capacity;
+	unsigned count;
+	unsigned allocated;
+	unsigned total;
+	unsigned escape;
+	unsigned mode;
+	unsigned bits;
+	unsigned escaped;
+	/* Most and least recently used entries. */
+	unsigned newest;
+	unsigned oldest;
+	unsigned slots_mask;
+	unsigned *slots;
+	sparse_model_entry *entries;
+	/* Fenwick tree over entry frequencies, 1-based. */
+	unsigned *tree;
+	freq_table length;
+	unsigned short length_freq[8 * sizeof(arcd_char_t) + 1];
+}
+sparse_model;
+
+/* Maximum number of symbols model can hold at once. */
+enum { SPARSE_MODEL_CAPACITY_MAX = ARCD_FREQ_MAX / 4 };
+
+void sparse_model_create(sparse_model *const m, const unsigned capacity);
+void sparse_model_free(sparse_model *const m);
+void sparse_model_getprob(const arcd_char_t ch, arcd_prob *const prob,
+						  void *const model);
+arcd_char_t sparse_model_getch(const arcd_range_t v, const arcd_range_t range,
+							   arcd_prob *const prob, void *const model);
+/* Encodes one value. Will call arcd_enc_put() one or more times. */
+void sparse_model_put(arcd_enc *const e, sparse_model *const m,
+					  const arcd_char_t ch);
+/* Decodes one value. Will call arcd_dec_get() one or more times. */
+arcd_char_t sparse_model_get(arcd_dec *const d, sparse_model *const m);
+
+#ifdef __cplusplus
+}
+#endif
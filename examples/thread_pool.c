@@ -0,0 +1,58 @@
+#include <stdlib.h>
+#include <pthread.h>
+#include "thread_pool.h"
+
+typedef struct pool
+{
+	pthread_mutex_t lock;
+	unsigned next;
+	unsigned count;
+	void (*run)(void *ctx, unsigned i);
+	void *ctx;
+}
+pool;
+
+static void *pool_worker(void *const arg)
+{
+	pool *const p = (pool *)arg;
+	for (;;)
+	{
+		pthread_mutex_lock(&p->lock);
+		const unsigned i = p->next++;
+		pthread_mutex_unlock(&p->lock);
+		if (p->count <= i)
+		{
+			return 0;
+		}
+		p->run(p->ctx, i);
+	}
+}
+
+void thread_pool_run(const unsigned count, const unsigned threads,
+					 void (*const run)(void *ctx, unsigned i), void *const ctx)
+{
+	pool p;
+	pthread_mutex_init(&p.lock, 0);
+	p.next = 0;
+	p.count = count;
+	p.run = run;
+	p.ctx = ctx;
+	const unsigned n = count < threads? count: threads;
+	pthread_t *const workers = (pthread_t *)malloc(
+			sizeof(workers[0]) * (0 < n? n: 1));
+	unsigned started = 0;
+	for (; started + 1 < n; ++started)
+	{
+		if (0 != pthread_create(&workers[started], 0, pool_worker, &p))
+		{
+			break;
+		}
+	}
+	pool_worker(&p);
+	for (unsigned i = 0; started > i; ++i)
+	{
+		pthread_join(workers[i], 0);
+	}
+	free(workers);
+	pthread_mutex_destroy(&p.lock);
+}
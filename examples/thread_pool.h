@@ -0,0 +1,18 @@
+#pragma once
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Calls run(ctx, i) for every i in [0, count) using up to threads threads
+ * (calling thread is one of them) and returns when all calls are done.
+ * Indices are handed out one at a time from a shared counter, so a thread
+ * that finishes early takes the next index. When threads can't be created,
+ * remaining work is done by the threads that were.
+ */
+void thread_pool_run(const unsigned count, const unsigned threads,
+					 void (*const run)(void *ctx, unsigned i), void *const ctx);
+
+#ifdef __cplusplus
+}
+#endif
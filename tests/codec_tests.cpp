@@ -2,6 +2,7 @@
 #include <string>
 #include <sstream>
 #include <numeric>
+#include <cmath>
 #include <arcd.h>
 
 #ifndef _countof
@@ -135,10 +136,52 @@ namespace
 		{"7b", mk_model({1, 3, 5, 7}), {0, 1, 2, 3}, "00000010011"},
 		{"7c", mk_model({7, 5, 3, 1}), {3, 2, 1, 0}, "11111101011"},
 		{"7d", mk_model({7, 5, 3, 1}), {0, 1, 2, 3}, "0101000110"},
+		{"7e", mk_model({1, 3, 5, 7}), {2, 1, 3}, "0100111"},
 		{"8a", mk_model({1, 255, 1}), {0, 2}, "00000000111111101"},
 		{"8b", mk_model({1, 255, 1}), {2, 0}, "11111111000000001"},
 	};
 
+	bool test_cost(const test_case &tc, const size_t i, const size_t bits)
+	{
+		model_t *const model = const_cast<model_t *>(&tc.model);
+		arcd_enc dry;
+		arcd_enc est;
+		arcd_enc_init(&dry, getprob, model, 0, 0);
+		arcd_enc_init_estimate(&est, getprob, model);
+		double ideal = 0;
+		for (size_t k = 0; tc.in.size() > k; ++k)
+		{
+			const arcd_prob &p = tc.model[tc.in[k]];
+			ideal -= std::log2((double)(p.upper - p.lower) / p.total);
+			arcd_enc_put(&dry, tc.in[k]);
+			arcd_enc_put(&est, tc.in[k]);
+		}
+		arcd_enc_fin(&dry);
+		arcd_enc_fin(&est);
+		bool ok = true;
+		const arcd_cost_t exact = arcd_enc_cost(&dry);
+		if ((arcd_cost_t)bits << ARCD_COST_FRAC_BITS != exact)
+		{
+			fprintf(stderr, "Test case #%zu \"%s\" (exact cost) failed:\n",
+					i, tc.name.c_str());
+			fprintf(stderr, "    Actual bits:   %g\n",
+					(double)exact / (1 << ARCD_COST_FRAC_BITS));
+			fprintf(stderr, "    Expected bits: %zu\n", bits);
+			ok = false;
+		}
+		const double estimate =
+				(double)arcd_enc_cost(&est) / (1 << ARCD_COST_FRAC_BITS);
+		if (0.01 * tc.in.size() < std::fabs(estimate - ideal))
+		{
+			fprintf(stderr, "Test case #%zu \"%s\" (estimate cost) failed:\n",
+					i, tc.name.c_str());
+			fprintf(stderr, "    Actual bits:   %g\n", estimate);
+			fprintf(stderr, "    Expected bits: %g\n", ideal);
+			ok = false;
+		}
+		return ok;
+	}
+
 	bool run_tests()
 	{
 		bool ok = true;
@@ -163,6 +206,11 @@ namespace
 				fprintf(stderr, "    Expected output: %s\n", tc.out.c_str());
 				ok = false;
 			}
+			if (!test_cost(tc, i, outstr.size()) ||
+				arcd_enc_cost(&enc) != (arcd_cost_t)outstr.size() << ARCD_COST_FRAC_BITS)
+			{
+				ok = false;
+			}
 			arcd_dec dec;
 			std::istringstream in(outstr);
 			arcd_dec_init(&dec, getch, const_cast<model_t *>(&tc.model),
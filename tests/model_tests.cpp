@@ -0,0 +1,484 @@
+#include <stdio.h>
+#include <stddef.h>
+#include <string.h>
+#include <vector>
+#include <algorithm>
+#include <random>
+#include <arcd.h>
+#include <sparse_model.h>
+#include <shared_model.h>
+#include <block_coder.h>
+#include <lz_coder.h>
+#include <numeric_coder.h>
+#include <column_coder.h>
+
+#ifndef _countof
+#define _countof(v) (sizeof(v) / sizeof((v)[0]))
+#endif
+
+namespace
+{
+	typedef std::vector<arcd_buf_t> buffer_t;
+
+	struct input_t
+	{
+		const buffer_t *buf;
+		size_t pos;
+	};
+
+	void output(const arcd_buf_t buf, const unsigned buf_bits, void *const io)
+	{
+		(void)buf_bits;
+		static_cast<buffer_t *>(io)->push_back(buf);
+	}
+
+	unsigned input(arcd_buf_t *const buf, void *const io)
+	{
+		input_t *const in = static_cast<input_t *>(io);
+		if (in->buf->size() <= in->pos)
+		{
+			return 0;
+		}
+		*buf = (*in->buf)[in->pos++];
+		return ARCD_BUF_BITS;
+	}
+
+	std::vector<arcd_char_t> mk_sparse_sequence(const size_t n)
+	{
+		std::mt19937 rng(1);
+		std::vector<arcd_char_t> hot(64);
+		for (size_t i = 0; hot.size() > i; ++i)
+		{
+			hot[i] = rng();
+		}
+		hot[0] = 0;
+		hot[1] = 1;
+		hot[2] = 0xffffffffu;
+		std::vector<arcd_char_t> seq(n);
+		for (size_t i = 0; n > i; ++i)
+		{
+			const unsigned r = rng() % 16;
+			seq[i] = 0 == r? rng(): hot[rng() % (4 < r? 8: hot.size())];
+		}
+		return seq;
+	}
+
+	/* Working set of 16 identifiers that is replaced every 2000 values. */
+	std::vector<arcd_char_t> mk_drifting_sequence(const size_t n)
+	{
+		std::mt19937 rng(2);
+		std::vector<arcd_char_t> hot(16);
+		std::vector<arcd_char_t> seq(n);
+		for (size_t i = 0; n > i; ++i)
+		{
+			if (0 == i % 2000)
+			{
+				for (size_t k = 0; hot.size() > k; ++k)
+				{
+					hot[k] = rng();
+				}
+			}
+			seq[i] = hot[rng() % hot.size()];
+		}
+		return seq;
+	}
+
+	/* Checks round trip and, when size_limit is not 0, that encoded size in
+	 * bytes doesn't exceed it.
+	 */
+	bool test_sparse_model(const char *const name, const unsigned capacity,
+						   const std::vector<arcd_char_t> &seq,
+						   const size_t size_limit)
+	{
+		buffer_t buf;
+		sparse_model model;
+		sparse_model_create(&model, capacity);
+		arcd_enc enc;
+		arcd_enc_init(&enc, sparse_model_getprob, &model, output, &buf);
+		for (size_t i = 0; seq.size() > i; ++i)
+		{
+			sparse_model_put(&enc, &model, seq[i]);
+		}
+		arcd_enc_fin(&enc);
+		const bool bounded = capacity >= model.allocated;
+		sparse_model_free(&model);
+		if (!bounded)
+		{
+			fprintf(stderr, "Test \"%s\" failed: model exceeded capacity\n",
+					name);
+			return false;
+		}
+		if (0 != size_limit && size_limit < buf.size())
+		{
+			fprintf(stderr, "Test \"%s\" failed:\n", name);
+			fprintf(stderr, "    Actual size: %zu\n", buf.size());
+			fprintf(stderr, "    Size limit:  %zu\n", size_limit);
+			return false;
+		}
+		input_t in = {&buf, 0};
+		sparse_model_create(&model, capacity);
+		arcd_dec dec;
+		arcd_dec_init(&dec, sparse_model_getch, &model, input, &in);
+		bool ok = true;
+		for (size_t i = 0; seq.size() > i; ++i)
+		{
+			const arcd_char_t ch = sparse_model_get(&dec, &model);
+			if (seq[i] != ch)
+			{
+				fprintf(stderr, "Test \"%s\" (decode) failed at #%zu:\n",
+						name, i);
+				fprintf(stderr, "    Actual symbol:   %u\n", ch);
+				fprintf(stderr, "    Expected symbol: %u\n", seq[i]);
+				ok = false;
+				break;
+			}
+		}
+		sparse_model_free(&model);
+		return ok;
+	}
+
+	/* Encodes data with shared model trained on sample, both alone and with
+	 * overlays. Encoders and decoders run interleaved and must not change the
+	 * shared model.
+	 */
+	bool test_shared_model(const char *const name,
+						   const std::vector<unsigned char> &sample,
+						   const std::vector<unsigned char> &data)
+	{
+		unsigned long hist[256] = {0};
+		for (size_t i = 0; sample.size() > i; ++i)
+		{
+			++hist[sample[i]];
+		}
+		shared_model shared;
+		shared_model_create(&shared, hist, 256);
+		const std::vector<unsigned short> freq(shared.freq,
+											   shared.freq + shared.size + 1);
+		shared_overlay overlays[2];
+		buffer_t bufs[3];
+		arcd_enc encs[3];
+		arcd_enc_init(&encs[0], shared_model_getprob, &shared, output, &bufs[0]);
+		for (unsigned k = 0; 2 > k; ++k)
+		{
+			shared_overlay_create(&overlays[k], &shared);
+			arcd_enc_init(&encs[k + 1], shared_overlay_getprob, &overlays[k],
+						  output, &bufs[k + 1]);
+		}
+		for (size_t i = 0; data.size() > i; ++i)
+		{
+			for (unsigned k = 0; 3 > k; ++k)
+			{
+				arcd_enc_put(&encs[k], data[i]);
+			}
+		}
+		input_t ins[3];
+		arcd_dec decs[3];
+		for (unsigned k = 0; 3 > k; ++k)
+		{
+			arcd_enc_fin(&encs[k]);
+			ins[k].buf = &bufs[k];
+			ins[k].pos = 0;
+		}
+		arcd_dec_init(&decs[0], shared_model_getch, &shared, input, &ins[0]);
+		for (unsigned k = 0; 2 > k; ++k)
+		{
+			shared_overlay_free(&overlays[k]);
+			shared_overlay_create(&overlays[k], &shared);
+			arcd_dec_init(&decs[k + 1], shared_overlay_getch, &overlays[k],
+						  input, &ins[k + 1]);
+		}
+		bool ok = true;
+		for (size_t i = 0; ok && data.size() > i; ++i)
+		{
+			for (unsigned k = 0; ok && 3 > k; ++k)
+			{
+				const arcd_char_t ch = arcd_dec_get(&decs[k]);
+				if (data[i] != ch)
+				{
+					fprintf(stderr, "Test \"%s\" (decode #%u) failed at #%zu\n",
+							name, k, i);
+					ok = false;
+				}
+			}
+		}
+		if (!std::equal(freq.begin(), freq.end(), shared.freq))
+		{
+			fprintf(stderr, "Test \"%s\" failed: shared model changed\n", name);
+			ok = false;
+		}
+		for (unsigned k = 0; 2 > k; ++k)
+		{
+			shared_overlay_free(&overlays[k]);
+		}
+		shared_model_free(&shared);
+		return ok;
+	}
+
+	bool test_block_coder(const char *const name,
+						  const std::vector<unsigned char> &data)
+	{
+		mem_buffer buf;
+		mem_buffer_init(&buf);
+		block_encode(data.data(), (unsigned)data.size(), &buf);
+		bool ok = BLOCK_HEADER_SIZE + block_payload_size(buf.data) == buf.size &&
+				  data.size() == block_decoded_size(buf.data) &&
+				  0 == block_check(buf.data);
+		std::vector<unsigned char> decoded(data.size() + 1);
+		if (ok)
+		{
+			ok = 0 == block_decode(buf.data, buf.data + BLOCK_HEADER_SIZE,
+								   decoded.data());
+			decoded.resize(data.size());
+		}
+		/* Payload size that block can't take must be rejected. */
+		mem_put_u32(buf.data + 8, 0xffffffffu);
+		if (0 == block_check(buf.data))
+		{
+			ok = false;
+		}
+		mem_buffer_free(&buf);
+		if (!ok || data != decoded)
+		{
+			fprintf(stderr, "Test \"%s\" failed\n", name);
+			return false;
+		}
+		return true;
+	}
+
+	bool test_lz_coder(const char *const name,
+					   const std::vector<unsigned char> &data)
+	{
+		for (unsigned level = LZ_LEVEL_MIN; LZ_LEVEL_MAX >= level; ++level)
+		{
+			mem_buffer buf;
+			mem_buffer_init(&buf);
+			lz_encode(data.data(), data.size(), level, &buf);
+			std::vector<unsigned char> decoded(data.size() + 1);
+			bool ok = data.size() == lz_decoded_size(buf.data) &&
+					  0 == lz_decode(buf.data, buf.size, decoded.data());
+			decoded.resize(data.size());
+			/* Truncated frames and frames with decoded size that payload
+			 * can't hold must be rejected.
+			 */
+			if (LZ_HEADER_SIZE < buf.size &&
+				0 == lz_check(buf.data, buf.size - 1))
+			{
+				ok = false;
+			}
+			mem_put_u32(buf.data, LZ_RATIO_MAX);
+			mem_put_u32(buf.data + 4, 0);
+			if (0 == lz_check(buf.data, buf.size))
+			{
+				ok = false;
+			}
+			mem_buffer_free(&buf);
+			if (!ok || data != decoded)
+			{
+				fprintf(stderr, "Test \"%s\" (level %u) failed\n", name, level);
+				return false;
+			}
+		}
+		return true;
+	}
+
+	bool test_numeric_coder(const char *const name,
+							const std::vector<int64_t> &values,
+							const unsigned transform)
+	{
+		mem_buffer buf;
+		mem_buffer_init(&buf);
+		numeric_encode(values.data(), values.size(), transform, &buf);
+		std::vector<int64_t> decoded(values.size() + 1);
+		bool ok = values.size() == numeric_decoded_count(buf.data) &&
+				  0 == numeric_decode(buf.data, buf.size, decoded.data());
+		decoded.resize(values.size());
+		/* Truncated frames and frames with value count that payload can't
+		 * hold must be rejected.
+		 */
+		if (NUMERIC_HEADER_SIZE < buf.size &&
+			0 == numeric_check(buf.data, buf.size - 1))
+		{
+			ok = false;
+		}
+		mem_put_u32(buf.data, NUMERIC_RATIO_MAX);
+		mem_put_u32(buf.data + 4, 0);
+		if (0 == numeric_check(buf.data, buf.size))
+		{
+			ok = false;
+		}
+		mem_buffer_free(&buf);
+		if (!ok || values != decoded)
+		{
+			fprintf(stderr, "Test \"%s\" (transform %u) failed\n",
+					name, transform);
+			return false;
+		}
+		return true;
+	}
+
+	bool test_numeric_coder(const char *const name,
+							const std::vector<int64_t> &values)
+	{
+		bool ok = true;
+		ok = test_numeric_coder(name, values, NUMERIC_RAW) && ok;
+		ok = test_numeric_coder(name, values, NUMERIC_DELTA) && ok;
+		ok = test_numeric_coder(name, values, NUMERIC_DELTA2) && ok;
+		return ok;
+	}
+
+	struct record_t
+	{
+		int64_t timestamp;
+		uint32_t user;
+		int16_t status;
+		int8_t level;
+		int32_t gauge;
+	};
+
+	bool operator==(const record_t &a, const record_t &b)
+	{
+		return a.timestamp == b.timestamp && a.user == b.user &&
+			   a.status == b.status && a.level == b.level && a.gauge == b.gauge;
+	}
+
+	bool test_column_coder(const char *const name, const size_t count,
+						   const unsigned threads)
+	{
+		static const column_field fields[] =
+		{
+			{offsetof(record_t, timestamp), 8, 1, COLUMN_NUMERIC, NUMERIC_DELTA2},
+			{offsetof(record_t, user), 4, 0, COLUMN_SPARSE, 0},
+			{offsetof(record_t, status), 2, 1, COLUMN_SPARSE, 0},
+			{offsetof(record_t, level), 1, 1, COLUMN_NUMERIC, NUMERIC_RAW},
+			{offsetof(record_t, gauge), 4, 1, COLUMN_NUMERIC, NUMERIC_DELTA},
+		};
+		std::mt19937 rng(4);
+		std::vector<record_t> records(count);
+		for (size_t i = 0; count > i; ++i)
+		{
+			record_t &r = records[i];
+			r.timestamp = 1600000000000 + 250 * (int64_t)i + rng() % 4;
+			r.user = 0 == rng() % 8? rng(): 1000 + rng() % 20;
+			r.status = 0 == rng() % 16? -1: 200;
+			r.level = (int8_t)(rng() % 256);
+			r.gauge = (int32_t)(rng() % 100) - 50 + (int32_t)i;
+		}
+		mem_buffer buf;
+		mem_buffer_init(&buf);
+		column_encode(fields, _countof(fields), records.data(), sizeof(record_t),
+					  count, threads, &buf);
+		bool ok = count == column_decoded_count(buf.data, buf.size);
+		std::vector<record_t> decoded(count);
+		ok = ok && 0 == column_decode(fields, _countof(fields), buf.data,
+									  buf.size, 0, 0, decoded.data(),
+									  sizeof(record_t), threads);
+		ok = ok && records == decoded;
+		/* Projection: only timestamp and gauge columns. */
+		static const unsigned select[] = {4, 0};
+		std::vector<record_t> projected(count, record_t());
+		ok = ok && 0 == column_decode(fields, _countof(fields), buf.data,
+									  buf.size, select, _countof(select),
+									  projected.data(), sizeof(record_t),
+									  threads);
+		for (size_t i = 0; ok && count > i; ++i)
+		{
+			const record_t &r = projected[i];
+			ok = r.timestamp == records[i].timestamp &&
+				 r.gauge == records[i].gauge && 0 == r.user && 0 == r.status;
+		}
+		/* The same column can't be selected twice. */
+		static const unsigned duplicate[] = {0, 4, 0};
+		if (0 == column_decode(fields, _countof(fields), buf.data, buf.size,
+							   duplicate, _countof(duplicate),
+							   projected.data(), sizeof(record_t), threads))
+		{
+			ok = false;
+		}
+		mem_buffer_free(&buf);
+		if (!ok)
+		{
+			fprintf(stderr, "Test \"%s\" failed\n", name);
+		}
+		return ok;
+	}
+
+	std::vector<unsigned char> mk_text(const size_t n)
+	{
+		static const char *const words[] =
+			{"arithmetic ", "coding ", "is ", "a ", "form ", "of ",
+			 "entropy ", "encoding ", "\n", "lossless "};
+		std::mt19937 rng(2);
+		std::vector<unsigned char> text;
+		while (n > text.size())
+		{
+			const char *const w = words[rng() % 10];
+			text.insert(text.end(), w, w + strlen(w));
+		}
+		text.resize(n);
+		return text;
+	}
+
+	bool run_tests()
+	{
+		bool ok = true;
+		const std::vector<arcd_char_t> sparse = mk_sparse_sequence(20000);
+		ok = test_sparse_model("sparse_model_small", 4, sparse, 0) && ok;
+		ok = test_sparse_model("sparse_model_medium", 48, sparse, 0) && ok;
+		ok = test_sparse_model("sparse_model_large", 4096, sparse, 0) && ok;
+		ok = test_sparse_model("sparse_model_evicting", 1000, sparse, 0) && ok;
+		/* 16 of 2000 values per phase are escapes, rest should take 4-5 bits
+		 * each when old identifiers leave the model in time.
+		 */
+		const std::vector<arcd_char_t> drifting = mk_drifting_sequence(20000);
+		ok = test_sparse_model("sparse_model_drift_small", 16, drifting,
+							   12000) && ok;
+		ok = test_sparse_model("sparse_model_drift_medium", 64, drifting,
+							   14000) && ok;
+		ok = test_shared_model("shared_model_text", mk_text(1000),
+							   mk_text(50000)) && ok;
+		ok = test_block_coder("block_coder_empty", {}) && ok;
+		ok = test_block_coder("block_coder_one", {42}) && ok;
+		ok = test_block_coder("block_coder_run",
+							  std::vector<unsigned char>(5000, 'a')) && ok;
+		ok = test_block_coder("block_coder_banana",
+							  {'b', 'a', 'n', 'a', 'n', 'a'}) && ok;
+		ok = test_block_coder("block_coder_text", mk_text(100000)) && ok;
+		std::mt19937 rng(3);
+		std::vector<unsigned char> noise(70000);
+		for (size_t i = 0; noise.size() > i; ++i)
+		{
+			noise[i] = (unsigned char)(rng() % (i < 30000? 4: 256));
+		}
+		ok = test_block_coder("block_coder_noise", noise) && ok;
+		ok = test_shared_model("shared_model_noise", mk_text(1000), noise) && ok;
+		ok = test_lz_coder("lz_coder_empty", {}) && ok;
+		ok = test_lz_coder("lz_coder_short", {'a', 'b', 'a', 'b'}) && ok;
+		ok = test_lz_coder("lz_coder_run",
+						   std::vector<unsigned char>(5000, 'a')) && ok;
+		ok = test_lz_coder("lz_coder_text", mk_text(100000)) && ok;
+		ok = test_lz_coder("lz_coder_noise", noise) && ok;
+		ok = test_numeric_coder("numeric_coder_empty", {}) && ok;
+		ok = test_numeric_coder("numeric_coder_extremes",
+								{0, 1, -1, INT64_MAX, INT64_MIN, INT64_MAX,
+								 0, INT64_MIN, -2, 2}) && ok;
+		std::vector<int64_t> timestamps(10000);
+		std::vector<int64_t> gauges(10000);
+		for (size_t i = 0; timestamps.size() > i; ++i)
+		{
+			timestamps[i] = 1600000000000 + 1000 * (int64_t)i + rng() % 8;
+			gauges[i] = (int64_t)(rng() % 2000) - 1000;
+		}
+		ok = test_numeric_coder("numeric_coder_timestamps", timestamps) && ok;
+		ok = test_numeric_coder("numeric_coder_gauges", gauges) && ok;
+		ok = test_column_coder("column_coder_empty", 0, 2) && ok;
+		ok = test_column_coder("column_coder_single_thread", 5000, 1) && ok;
+		ok = test_column_coder("column_coder_threads", 5000, 4) && ok;
+		return ok;
+	}
+}
+
+int main(int argc, char *argv[])
+{
+	(void)argc; (void)argv;
+	return run_tests()? 0: 1;
+}
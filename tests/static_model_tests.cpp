@@ -0,0 +1,148 @@
+#include <vector>
+#include <string>
+#include <sstream>
+#include <cstdio>
+#include <cstdlib>
+#include <arcd.h>
+#include "skewed_model.h"
+#include "text_model.h"
+
+#ifndef _countof
+#define _countof(v) (sizeof(v) / sizeof((v)[0]))
+#endif
+
+namespace
+{
+	void output(const arcd_buf_t buf, const unsigned buf_bits, void *const io)
+	{
+		std::ostringstream *const s = static_cast<std::ostringstream *>(io);
+		for (unsigned i = ARCD_BUF_BITS, e = ARCD_BUF_BITS - buf_bits; e < i--;)
+		{
+			s->put(1 & (buf >> i)? '1': '0');
+		}
+	}
+
+	unsigned input(arcd_buf_t *const buf, void *const io)
+	{
+		std::istringstream *const s = static_cast<std::istringstream *>(io);
+		std::istringstream::char_type ch;
+		*buf = 0;
+		unsigned bits = ARCD_BUF_BITS;
+		while (0 < bits && *s >> ch)
+		{
+			*buf |= ('0' == ch? 0: 1) << --bits;
+		}
+		return ARCD_BUF_BITS - bits;
+	}
+
+	std::string encode(arcd_getprob_t getprob,
+					   const std::vector<arcd_char_t> &in)
+	{
+		arcd_enc enc;
+		std::ostringstream out;
+		arcd_enc_init(&enc, getprob, 0, output, &out);
+		for (size_t k = 0; in.size() > k; ++k)
+		{
+			arcd_enc_put(&enc, in[k]);
+		}
+		arcd_enc_fin(&enc);
+		return out.str();
+	}
+
+	std::vector<arcd_char_t> decode(arcd_getch_t getch, const std::string &bits,
+									const size_t count)
+	{
+		arcd_dec dec;
+		std::istringstream in(bits);
+		arcd_dec_init(&dec, getch, 0, input, &in);
+		std::vector<arcd_char_t> out;
+		for (size_t k = 0; count > k; ++k)
+		{
+			out.push_back(arcd_dec_get(&dec));
+		}
+		return out;
+	}
+
+	struct test_case
+	{
+		const std::string name;
+		const std::vector<arcd_char_t> in;
+		const std::string out;
+	};
+
+	/* Same cases as for mk_model({1, 3, 5, 7}) in codec_tests. */
+	const test_case c_test_cases[] =
+	{
+		{"7a", {3, 2, 1, 0}, "1010111001"},
+		{"7b", {0, 1, 2, 3}, "00000010011"},
+		{"7e", {2, 1, 3}, "0100111"},
+	};
+
+	bool test_skewed_model()
+	{
+		bool ok = true;
+		for (size_t i = 0; _countof(c_test_cases) > i; ++i)
+		{
+			const test_case &tc = c_test_cases[i];
+			const std::string outstr = encode(skewed_model_getprob, tc.in);
+			if (tc.out != outstr)
+			{
+				fprintf(stderr, "Test case #%zu \"%s\" (encode) failed:\n",
+						i, tc.name.c_str());
+				fprintf(stderr, "    Actual output:   %s\n", outstr.c_str());
+				fprintf(stderr, "    Expected output: %s\n", tc.out.c_str());
+				ok = false;
+			}
+			if (tc.in != decode(skewed_model_getch, outstr, tc.in.size()))
+			{
+				fprintf(stderr, "Test case #%zu \"%s\" (decode) failed\n",
+						i, tc.name.c_str());
+				ok = false;
+			}
+		}
+		return ok;
+	}
+
+	bool test_text_model()
+	{
+		bool ok = true;
+		arcd_freq_t total = 0;
+		for (arcd_char_t ch = 0; TEXT_MODEL_SYMBOLS > ch; ++ch)
+		{
+			arcd_prob prob;
+			text_model_getprob(ch, &prob, 0);
+			if (total != prob.lower || prob.lower >= prob.upper ||
+				TEXT_MODEL_TOTAL != prob.total)
+			{
+				fprintf(stderr, "Text model: bad interval for symbol %u\n", ch);
+				ok = false;
+			}
+			total = prob.upper;
+		}
+		if (TEXT_MODEL_TOTAL != total || ARCD_FREQ_MAX < total)
+		{
+			fprintf(stderr, "Text model: bad total %u\n", total);
+			ok = false;
+		}
+		std::vector<arcd_char_t> in(10000);
+		srand(1);
+		for (size_t k = 0; in.size() > k; ++k)
+		{
+			in[k] = 0 == k % 7? rand() % TEXT_MODEL_SYMBOLS: "arcd "[k % 5];
+		}
+		const std::string bits = encode(text_model_getprob, in);
+		if (in != decode(text_model_getch, bits, in.size()))
+		{
+			fprintf(stderr, "Text model: round trip failed\n");
+			ok = false;
+		}
+		return ok;
+	}
+}
+
+int main(int argc, char *argv[])
+{
+	(void)argc; (void)argv;
+	const bool ok = test_skewed_model();
+	return test_text_model() && ok? 0: 1;
+}
@@ -0,0 +1,176 @@
+#!/usr/bin/python
+
+from __future__ import print_function
+
+import os
+import sys
+import argparse
+
+# Must match ARCD_FREQ_MAX from arcd.h.
+FREQ_MAX = 2 ** 15 - 1
+
+def str_to_list(s):
+	return [int(v) for v in s.replace(",", " ").split()]
+
+def read_histogram(path):
+	with open(path, "r") as f:
+		return str_to_list(f.read())
+
+def read_corpus(path, symbols):
+	hist = [0] * symbols
+	with open(path, "rb") as f:
+		for b in bytearray(f.read()):
+			if b >= symbols:
+				raise ValueError("corpus byte %i is out of alphabet" % b)
+			hist[b] += 1
+	return hist
+
+def normalize(hist, total):
+	"""Scales histogram to the specified total. Every symbol gets at least 1,
+	so symbols that are absent from the histogram can still be coded.
+	Rounding error is distributed using largest remainder method."""
+	s = sum(hist)
+	freqs = [max(1, h * total // s) for h in hist]
+	by_remainder = sorted(range(len(hist)), key=lambda i: -(hist[i] * total % s))
+	i = 0
+	while sum(freqs) < total:
+		freqs[by_remainder[i % len(hist)]] += 1
+		i += 1
+	while sum(freqs) > total:
+		largest = max(range(len(hist)), key=lambda i: freqs[i])
+		freqs[largest] -= 1
+	return freqs
+
+def partial_sums(a):
+	sums = [0]
+	for x in a:
+		sums.append(sums[-1] + x)
+	return sums
+
+def format_array(values, indent="\t", width=80):
+	lines = []
+	line = indent
+	for v in values:
+		item = "%i," % v
+		if len(line) + len(item) + 1 > width and line != indent:
+			lines.append(line.rstrip())
+			line = indent
+		line += item + " "
+	if line != indent:
+		lines.append(line.rstrip())
+	return "\n".join(lines)
+
+def gen_header(name, freqs, source):
+	prefix = name.upper()
+	total = sum(freqs)
+	cumulative = partial_sums(freqs)
+	lookup = []
+	for ch in range(len(freqs)):
+		lookup += [ch] * freqs[ch]
+	lookup_type = "unsigned char" if len(freqs) <= 256 else "unsigned short"
+	return """/* Generated by gen_model.py from %(source)s. Do not edit. */
+#pragma once
+
+#include <arcd.h>
+
+enum { %(prefix)s_SYMBOLS = %(symbols)i };
+enum { %(prefix)s_TOTAL = %(total)i };
+
+/* Cumulative frequencies: symbol ch has [freq[ch], freq[ch + 1]) interval. */
+static const unsigned short %(name)s_freq[%(prefix)s_SYMBOLS + 1] =
+{
+%(cumulative)s
+};
+
+/* Symbol for every cumulative frequency value. */
+static const %(lookup_type)s %(name)s_lookup[%(prefix)s_TOTAL] =
+{
+%(lookup)s
+};
+
+static inline
+void %(name)s_getprob(const arcd_char_t ch, arcd_prob *const prob,
+%(getprob_indent)svoid *const model)
+{
+	(void)model;
+	prob->lower = %(name)s_freq[ch];
+	prob->upper = %(name)s_freq[ch + 1];
+	prob->total = %(prefix)s_TOTAL;
+}
+
+static inline
+arcd_char_t %(name)s_getch(const arcd_range_t v, const arcd_range_t range,
+%(getch_indent)sarcd_prob *const prob, void *const model)
+{
+	(void)model;
+	const arcd_char_t ch =
+			%(name)s_lookup[arcd_freq_scale(v, range, %(prefix)s_TOTAL)];
+	prob->lower = %(name)s_freq[ch];
+	prob->upper = %(name)s_freq[ch + 1];
+	prob->total = %(prefix)s_TOTAL;
+	return ch;
+}
+""" % {
+		"source": source,
+		"prefix": prefix,
+		"name": name,
+		"symbols": len(freqs),
+		"total": total,
+		"cumulative": format_array(cumulative),
+		"lookup_type": lookup_type,
+		"lookup": format_array(lookup),
+		"getprob_indent": " " * len("void %s_getprob(" % name),
+		"getch_indent": " " * len("arcd_char_t %s_getch(" % name),
+	}
+
+def main(argv):
+	parser = argparse.ArgumentParser(
+			description="Generates C header with static model.")
+	parser.add_argument("-n", "--name", metavar="NAME", required=True,
+			help="Model name, used as prefix for generated identifiers")
+	source = parser.add_mutually_exclusive_group(required=True)
+	source.add_argument("-m", "--model", metavar="MODEL",
+			help="Histogram, example: \"1, 2, 4\"")
+	source.add_argument("-f", "--histogram", metavar="FILE",
+			help="File with histogram (integers separated by spaces or commas)")
+	source.add_argument("-c", "--corpus", metavar="FILE",
+			help="Sample file, histogram of its bytes is used")
+	parser.add_argument("-s", "--symbols", metavar="N", type=int, default=256,
+			help="Alphabet size for corpus (default: 256)")
+	parser.add_argument("-t", "--total", metavar="N", type=int, default=None,
+			help="Total frequency (default: histogram sum if it fits, 4096 otherwise)")
+	parser.add_argument("-o", "--output", metavar="FILE", default=None,
+			help="Output file (default: stdout)")
+	args = parser.parse_args(argv)
+
+	try:
+		if args.model is not None:
+			hist, source = str_to_list(args.model), "\"%s\"" % args.model
+		elif args.histogram is not None:
+			hist, source = read_histogram(args.histogram), os.path.basename(args.histogram)
+		else:
+			hist, source = read_corpus(args.corpus, args.symbols), os.path.basename(args.corpus)
+	except (IOError, ValueError) as e:
+		print("Error: %s" % e, file=sys.stderr)
+		return 1
+	if 0 == len(hist) or 0 == sum(hist) or 0 > min(hist):
+		print("Error: histogram must be non-empty and non-negative", file=sys.stderr)
+		return 1
+	total = args.total
+	if total is None:
+		total = sum(hist) if sum(hist) <= FREQ_MAX and 0 < min(hist) else 4096
+	if total < len(hist) or total > FREQ_MAX:
+		print("Error: total must be in [%i, %i] range" % (len(hist), FREQ_MAX),
+				file=sys.stderr)
+		return 1
+	source = source.replace("*/", "* /")
+	header = gen_header(args.name, normalize(hist, total), source)
+	if args.output is None:
+		sys.stdout.write(header)
+	else:
+		with open(args.output, "w") as f:
+			f.write(header)
+	return 0
+
+if __name__ == "__main__":
+	sys.exit(main(sys.argv[1:]))